@@ -0,0 +1,58 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra\Bench;
+
+/**
+ * The measurements of a benchmark case
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Result
+{
+    /**
+     * Creates a new Result
+     *
+     * @param $opsPerSecond - The number of times the case ran per second
+     * @param $bytesPerOp - The memory held by the value of a single run
+     * @param $retainedBytes - The memory still in use after every run, beyond what was in use before the first
+     */
+    public function __construct(private float $opsPerSecond, private int $bytesPerOp, private int $retainedBytes)
+    {
+    }
+
+    /**
+     * Gets the number of times the case ran per second
+     *
+     * @return - The operations per second
+     */
+    public function getOpsPerSecond(): float
+    {
+        return $this->opsPerSecond;
+    }
+
+    /**
+     * Gets the memory held by the value of a single run
+     *
+     * @return - The number of bytes
+     */
+    public function getBytesPerOp(): int
+    {
+        return $this->bytesPerOp;
+    }
+
+    /**
+     * Gets the memory still in use after every run, beyond what was in use before the first
+     *
+     * @return - The number of bytes, which is above zero if the case keeps memory it doesn't need
+     */
+    public function getRetainedBytes(): int
+    {
+        return $this->retainedBytes;
+    }
+}
@@ -0,0 +1,151 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra\Bench;
+
+/**
+ * Runs benchmark cases and compares them to a baseline
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Runner
+{
+    /**
+     * Creates a new Runner
+     *
+     * @param $tolerance - The fraction of baseline throughput a case may lose before it fails
+     */
+    public function __construct(private float $tolerance = 0.25)
+    {
+    }
+
+    /**
+     * Measures a benchmark case.
+     *
+     * The case is warmed up first so the JIT has a chance to compile it.
+     * Memory is measured as the change in `memory_get_usage` around the case,
+     * not the peak of the process, so each case's numbers are its own.
+     *
+     * @param $iterations - The number of times to run the case
+     * @param $case - The case
+     * @return - The measurements
+     */
+    public function measure(int $iterations, (function(): mixed) $case): Result
+    {
+        $warmup = max(1, (int)($iterations / 10));
+        for ($i = 0; $i < $warmup; $i++) {
+            $case();
+        }
+        gc_collect_cycles();
+        $before = memory_get_usage();
+        $value = $case();
+        $bytes = memory_get_usage() - $before;
+        $value = null;
+        gc_collect_cycles();
+        $before = memory_get_usage();
+        $start = microtime(true);
+        for ($i = 0; $i < $iterations; $i++) {
+            $case();
+        }
+        $elapsed = max(microtime(true) - $start, 0.000001);
+        gc_collect_cycles();
+        $retained = max(0, memory_get_usage() - $before);
+        return new Result($iterations / $elapsed, $bytes, $retained);
+    }
+
+    /**
+     * Compares results to a baseline.
+     *
+     * @param $results - The results by case name
+     * @param $baseline - The baseline operations per second by case name
+     * @return - A message for each case slower than the baseline allows, or missing from it
+     */
+    public function compare(ImmMap<string,Result> $results, ImmMap<string,float> $baseline): ImmVector<string>
+    {
+        $failures = Vector{};
+        foreach ($results as $name => $result) {
+            $expected = $baseline->get($name);
+            if ($expected === null) {
+                $failures[] = "$name: no baseline; run with --save-baseline to record one";
+                continue;
+            }
+            $floor = $expected * (1 - $this->tolerance);
+            if ($result->getOpsPerSecond() < $floor) {
+                $failures[] = sprintf(
+                    "%s: %.1f ops/s is below the baseline of %.1f ops/s",
+                    $name,
+                    $result->getOpsPerSecond(),
+                    $expected
+                );
+            }
+        }
+        return $failures->immutable();
+    }
+
+    /**
+     * Checks that the cases measured at two sizes scale linearly.
+     *
+     * A case named `name-4x` runs on four times the input of `name-1x`, so it
+     * should take about four times as long; quadratic work takes sixteen. The
+     * ratio doesn't depend on the machine, so no baseline is needed.
+     *
+     * @param $results - The results by case name
+     * @return - A message for each pair more than 10 times slower at the larger size
+     */
+    public function compareScaling(ImmMap<string,Result> $results): ImmVector<string>
+    {
+        $failures = Vector{};
+        foreach ($results as $name => $large) {
+            if (substr($name, -3) !== '-4x') {
+                continue;
+            }
+            $small = $results->get(substr($name, 0, -3) . '-1x');
+            if ($small === null) {
+                continue;
+            }
+            $ratio = $small->getOpsPerSecond() / $large->getOpsPerSecond();
+            if ($ratio > 10) {
+                $failures[] = sprintf("%s: %.1f times slower than the 1x input; expected about 4", $name, $ratio);
+            }
+        }
+        return $failures->immutable();
+    }
+
+    /**
+     * Reads a baseline file.
+     *
+     * @param $path - The JSON file of operations per second by case name
+     * @return - The baseline, empty if the file doesn't exist
+     */
+    public function readBaseline(string $path): ImmMap<string,float>
+    {
+        $baseline = Map{};
+        if (!is_readable($path)) {
+            return $baseline->immutable();
+        }
+        $data = json_decode((string)file_get_contents($path), true);
+        if (is_array($data)) {
+            foreach ($data as $name => $ops) {
+                $baseline[(string)$name] = (float)$ops;
+            }
+        }
+        return $baseline->immutable();
+    }
+
+    /**
+     * Writes a baseline file.
+     *
+     * @param $path - The JSON file to write
+     * @param $results - The results by case name
+     */
+    public function writeBaseline(string $path, ImmMap<string,Result> $results): void
+    {
+        $data = $results->map($r ==> round($r->getOpsPerSecond(), 1))->toArray();
+        file_put_contents($path, json_encode($data, JSON_PRETTY_PRINT) . PHP_EOL);
+    }
+}
@@ -0,0 +1,163 @@
+<?hh
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra\Bench;
+
+use Cleopatra\Option;
+use Cleopatra\OptionSet;
+use Cleopatra\Parser;
+use Cleopatra\ShellWords;
+
+/**
+ * The benchmark cases
+ *
+ * Each case is a closure run repeatedly by the `Runner`; anything built
+ * outside of the closure isn't measured. The `worst-` cases feed adversarial
+ * input at two sizes, `-1x` and `-4x`, so the runner can check that they
+ * scale linearly.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Suite
+{
+    /**
+     * Gets the benchmark cases.
+     *
+     * @return - The number of iterations and the closure to run, by case name
+     */
+    public function getCases(): ImmMap<string,Pair<int,(function(): mixed)>>
+    {
+        $specs = self::specs(100);
+        $set = self::optionSet(100);
+        $left = self::optionSet(50);
+        $right = new OptionSet(...self::specs(50, 'other')->map($s ==> new Option($s, "Other option $s")));
+        $parser = new Parser($set);
+        $typical = ['test.hh', '-qe', 'foo', '-e', 'bar', '--nice', '123', 'run-tests', '-vvv', '--log=errors.log', '-xebaz', 'src'];
+        $manyOptions = ['test.hh'];
+        for ($i = 0; $i < 500; $i++) {
+            $manyOptions[] = '--option' . ($i % 100);
+            $manyOptions[] = "value$i";
+        }
+        $positional = ['test.hh'];
+        for ($i = 0; $i < 100000; $i++) {
+            $positional[] = "src/file$i.hh";
+        }
+        $bundle = ['test.hh', '-' . str_repeat('v', 10000)];
+        $multi = ['test.hh'];
+        for ($i = 0; $i < 10000; $i++) {
+            $multi[] = '-e';
+            $multi[] = "pattern$i";
+        }
+        $dates = ['test.hh'];
+        for ($i = 0; $i < 1000; $i++) {
+            $dates[] = '--when';
+            $dates[] = date('Y-m-d', 1451606400 + $i * 86400);
+        }
+        $batch = [];
+        for ($i = 0; $i < 1000; $i++) {
+            $batch[] = $typical;
+        }
+        $abbreviating = new Parser($set, Parser::ABBREVIATE);
+        $worst = Map{};
+        foreach ([1, 4] as $scale) {
+            $n = 25000 * $scale;
+            $bundled = ['test.hh', '-' . str_repeat('v', $n)];
+            $worst["worst-bundle-{$scale}x"] = Pair{10, () ==> $parser->parse($bundled)};
+            $equals = ['test.hh', '--log=a' . str_repeat('=', $n), '-e', str_repeat('=', $n)];
+            $worst["worst-equals-{$scale}x"] = Pair{10, () ==> $parser->parse($equals)};
+            $labels = ['test.hh', '--' . str_repeat('x', $n), '--' . str_repeat('x', $n) . '=1', '--' . str_repeat('e', $n)];
+            $worst["worst-labels-{$scale}x"] = Pair{10, () ==> $abbreviating->tryParse($labels)};
+            $dashes = array_fill(0, $n + 1, '--');
+            $worst["worst-dashes-{$scale}x"] = Pair{10, () ==> $parser->parse($dashes)};
+            $quotes = "test.hh '" . str_repeat('a', $n) . "' \"" . str_repeat('\\"', $n) . '" ' . str_repeat('b\\ ', $n);
+            $worst["worst-quotes-{$scale}x"] = Pair{10, () ==> new Vector(ShellWords::split($quotes))};
+        }
+        $getoptLongs = self::specs(100)->toArray();
+        foreach (['help', 'verbose', 'exclude:', 'nice:', 'quiet', 'experimental', 'log::', 'when:'] as $long) {
+            $getoptLongs[] = $long;
+        }
+        $cases = Map{
+            'option-construct' => Pair{10000, () ==> new Option('e|exclude:s@', 'Excludes files')},
+            'optionset-construct' => Pair{1000, () ==> self::optionSet(100)},
+            'optionset-combine' => Pair{1000, () ==> $left->combine($right)},
+            'help' => Pair{1000, () ==> $set->getHelp()},
+            'parse-typical' => Pair{10000, () ==> $parser->parse($typical)},
+            'parse-batch' => Pair{10, () ==> {
+                foreach ($batch as $arguments) {
+                    $parser->parse($arguments);
+                }
+            }},
+            'parse-many-options' => Pair{1000, () ==> $parser->parse($manyOptions)},
+            'parse-positional' => Pair{10, () ==> $parser->parse($positional)},
+            'parse-bundle' => Pair{100, () ==> $parser->parse($bundle)},
+            'parse-multiple' => Pair{100, () ==> $parser->parse($multi)},
+            'parse-dates' => Pair{100, () ==> $parser->parse($dates)},
+            'getopt-typical' => Pair{10000, () ==> self::getopt($typical, 'hve:qx', $getoptLongs)},
+            'getopt-many-options' => Pair{1000, () ==> self::getopt($manyOptions, '', $getoptLongs)},
+        };
+        foreach ($worst as $name => $case) {
+            $cases[$name] = $case;
+        }
+        return $cases->immutable();
+    }
+
+    /**
+     * Creates option specs, each taking a required value.
+     *
+     * @param $count - The number of specs
+     * @param $prefix - The label prefix
+     * @return - The specs
+     */
+    private static function specs(int $count, string $prefix = 'option'): ImmVector<string>
+    {
+        $specs = Vector{};
+        for ($i = 0; $i < $count; $i++) {
+            $specs[] = "$prefix$i:";
+        }
+        return $specs->immutable();
+    }
+
+    /**
+     * Creates an option set with the usual options plus a number of others.
+     *
+     * @param $count - The number of other options
+     * @return - The option set
+     */
+    private static function optionSet(int $count): OptionSet
+    {
+        $options = Vector{
+            new Option("h|help", "Display this help"),
+            new Option("v|verbose+", "Enables verbose output; use multiple times to increase verbosity"),
+            new Option("e|exclude:s@", "Excludes files and folders from processing"),
+            new Option("nice:i", "Sets the process nice value"),
+            new Option("q|quiet", "Disables all output to stdout"),
+            new Option("x|experimental", "Enables experimental features"),
+            new Option("log::", "Enables log output; default is syslog, but you can specify a log filename"),
+            new Option("when:d@", "Dates to process"),
+        };
+        foreach (self::specs($count) as $spec) {
+            $options[] = new Option($spec, "Sets the value of $spec");
+        }
+        return new OptionSet(...$options);
+    }
+
+    /**
+     * Runs the builtin getopt function on a list of arguments.
+     *
+     * @param $argv - The arguments
+     * @param $shorts - The short options
+     * @param $longs - The long options
+     * @return - The parsed options
+     */
+    private static function getopt(array<string> $argv, string $shorts, array<string> $longs): mixed
+    {
+        // getopt only reads arguments from the superglobal
+        $_SERVER['argv'] = $argv;
+        return getopt($shorts, $longs);
+    }
+}
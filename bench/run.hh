@@ -0,0 +1,67 @@
+<?hh
+/**
+ * Cleopatra
+ *
+ * Runs the benchmarks: `hhvm bench/run.hh [--filter=parse] [--save-baseline] [--require-baseline]`
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+require_once __DIR__ . '/../vendor/autoload.php';
+
+use Cleopatra\Option;
+use Cleopatra\OptionSet;
+use Cleopatra\Parser;
+use Cleopatra\Bench\Runner;
+use Cleopatra\Bench\Suite;
+
+$optionSet = new OptionSet(
+    new Option("h|help", "Display this help"),
+    new Option("f|filter:", "Only run cases whose names contain this string"),
+    new Option("b|baseline:", "The baseline file; default is bench/baseline.json"),
+    new Option("t|tolerance:f", "The fraction of baseline throughput a case may lose; default is 0.25"),
+    new Option("save-baseline", "Write the results to the baseline file instead of comparing"),
+    new Option("require-baseline", "Fail if the baseline file is missing instead of warning")
+);
+$options = (new Parser($optionSet))->parse($_SERVER['argv'])->getOptions();
+if ($options->containsKey('help') || $options->containsKey('h')) {
+    echo $optionSet->getHelp();
+    exit(0);
+}
+$get = ($long, $short, $default) ==> $options->containsKey($long) ?
+    $options[$long] : ($options->containsKey($short) ? $options[$short] : $default);
+$filter = (string)$get('filter', 'f', '');
+$baselineFile = (string)$get('baseline', 'b', __DIR__ . '/baseline.json');
+$runner = new Runner((float)$get('tolerance', 't', 0.25));
+
+$results = Map{};
+foreach ((new Suite())->getCases() as $name => $case) {
+    if ($filter !== '' && strpos($name, $filter) === false) {
+        continue;
+    }
+    $result = $runner->measure($case[0], $case[1]);
+    $results[$name] = $result;
+    printf("%-22s %14.1f ops/s %12d B/op %12d B retained\n",
+        $name, $result->getOpsPerSecond(), $result->getBytesPerOp(), $result->getRetainedBytes());
+}
+
+if ($options->containsKey('save-baseline')) {
+    $runner->writeBaseline($baselineFile, $results->immutable());
+    echo "Baseline written to $baselineFile", PHP_EOL;
+    exit(0);
+}
+$scaling = $runner->compareScaling($results->immutable());
+foreach ($scaling as $failure) {
+    fwrite(STDERR, "SUPERLINEAR $failure" . PHP_EOL);
+}
+$baseline = $runner->readBaseline($baselineFile);
+if ($baseline->isEmpty()) {
+    $required = $options->containsKey('require-baseline');
+    fwrite(STDERR, ($required ? "" : "WARNING ") . "No baseline found at $baselineFile; run with --save-baseline to record one" . PHP_EOL);
+    exit($required ? 2 : ($scaling->isEmpty() ? 0 : 1));
+}
+$failures = $runner->compare($results->immutable(), $baseline);
+foreach ($failures as $failure) {
+    fwrite(STDERR, "REGRESSION $failure" . PHP_EOL);
+}
+exit($failures->isEmpty() && $scaling->isEmpty() ? 0 : 1);
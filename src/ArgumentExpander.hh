@@ -0,0 +1,191 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Expands response files and argument streams into a list of arguments
+ *
+ * An argument like `@files.txt` is replaced by the arguments stored in that
+ * file, and `--args-from path` (or `--args-from -` for stdin) is replaced by
+ * the arguments read from that path. Arguments are separated by newlines, or
+ * by NUL bytes if any appear in the first chunk read (e.g. `find -print0`).
+ * Blank lines are skipped, but empty NUL-delimited records are kept as empty
+ * arguments. Arguments read with `--args-from` are passed through as-is, so
+ * paths starting with `@` or `--` are never expanded again.
+ * Sources are read in fixed-size chunks as the arguments are consumed, so
+ * memory use doesn't grow with the number of arguments.
+ *
+ * Nothing is expanded after a double dash (`--`).
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ArgumentExpander
+{
+    /**
+     * The number of bytes read from a source at a time
+     */
+    const int CHUNK_SIZE = 8192;
+
+    /**
+     * Creates a new ArgumentExpander
+     *
+     * @param $maxDepth - The maximum nesting of response files and streams
+     * @param $argsFrom - The long option which reads arguments from a path, or an empty string to disable it
+     */
+    public function __construct(private int $maxDepth = 10, private string $argsFrom = 'args-from')
+    {
+    }
+
+    /**
+     * Expands a list of arguments.
+     *
+     * The first argument is the program and is never expanded.
+     *
+     * @param $arguments - The arguments
+     * @return - The expanded arguments
+     * @throws \UnexpectedValueException if a source can't be read, is nested too deeply, or includes itself
+     */
+    public function expand(Traversable<string> $arguments): Generator<int,string,void>
+    {
+        $sources = Vector{self::iterate($arguments)};
+        $paths = Vector{''};
+        $verbatim = Vector{false};
+        $program = false;
+        $literal = false;
+        $argsFrom = $this->argsFrom === '' ? null : '--' . $this->argsFrom;
+        $argsFromLength = $argsFrom === null ? 0 : strlen($argsFrom);
+        $pending = false;
+        while (!$sources->isEmpty()) {
+            $source = $sources->lastValue();
+            if ($source === null || !$source->valid()) {
+                $sources->pop();
+                $paths->pop();
+                $verbatim->pop();
+                continue;
+            }
+            $arg = $source->current();
+            $source->next();
+            $path = null;
+            $stream = true;
+            if (!$program) {
+                $program = true;
+            } elseif ($literal || $verbatim->lastValue()) {
+                // pass everything through
+            } elseif ($pending) {
+                $pending = false;
+                $path = $arg;
+            } elseif ($arg === '--') {
+                $literal = true;
+            } elseif ($arg === $argsFrom) {
+                $pending = true;
+                continue;
+            } elseif ($argsFrom !== null && substr($arg, 0, $argsFromLength + 1) === "$argsFrom=") {
+                $path = (string)substr($arg, $argsFromLength + 1);
+            } elseif (strlen($arg) > 1 && $arg[0] === '@') {
+                $path = (string)substr($arg, 1);
+                $stream = false;
+            }
+            if ($path === null) {
+                yield $arg;
+                continue;
+            }
+            if ($sources->count() > $this->maxDepth) {
+                throw new \UnexpectedValueException("Response files are nested too deeply: $path");
+            }
+            $key = $path === '-' ? '-' : realpath($path);
+            if (!is_string($key)) {
+                throw new \UnexpectedValueException("Cannot read arguments from: $path");
+            } elseif ($paths->linearSearch($key) !== -1) {
+                throw new \UnexpectedValueException("Response file includes itself: $path");
+            }
+            $handle = fopen($key === '-' ? 'php://stdin' : $key, 'r');
+            if (!is_resource($handle)) {
+                throw new \UnexpectedValueException("Cannot read arguments from: $path");
+            }
+            $sources[] = self::read($handle);
+            $paths[] = $key;
+            $verbatim[] = $stream;
+        }
+        if ($pending) {
+            throw new \UnexpectedValueException("Option $argsFrom expects a value");
+        }
+    }
+
+    /**
+     * Iterates over any kind of Traversable.
+     *
+     * @param $arguments - The arguments
+     * @return - The arguments
+     */
+    private static function iterate(Traversable<string> $arguments): Generator<int,string,void>
+    {
+        foreach ($arguments as $arg) {
+            yield $arg;
+        }
+    }
+
+    /**
+     * Reads delimited arguments from a stream, then closes it.
+     *
+     * Empty lines are skipped, but empty NUL-delimited records are kept; only
+     * the empty remainder after a trailing NUL is dropped.
+     *
+     * @param $handle - The stream
+     * @return - The arguments
+     */
+    private static function read(resource $handle): Generator<int,string,void>
+    {
+        $buffer = '';
+        $delimiter = '';
+        try {
+            while (!feof($handle)) {
+                $chunk = fread($handle, self::CHUNK_SIZE);
+                if (!is_string($chunk) || $chunk === '') {
+                    break;
+                }
+                if ($delimiter === '') {
+                    $delimiter = strpos($chunk, "\0") === false ? "\n" : "\0";
+                }
+                $buffer .= $chunk;
+                $start = 0;
+                $end = strpos($buffer, $delimiter);
+                while ($end !== false) {
+                    $arg = self::trimRecord((string)substr($buffer, $start, $end - $start), $delimiter);
+                    if ($arg !== '' || $delimiter === "\0") {
+                        yield $arg;
+                    }
+                    $start = $end + 1;
+                    $end = strpos($buffer, $delimiter, $start);
+                }
+                $buffer = (string)substr($buffer, $start);
+            }
+            $arg = self::trimRecord($buffer, $delimiter);
+            if ($arg !== '') {
+                yield $arg;
+            }
+        } finally {
+            fclose($handle);
+        }
+    }
+
+    /**
+     * Removes a carriage return from the end of a newline-delimited record.
+     *
+     * @param $record - The record
+     * @param $delimiter - The delimiter in use
+     * @return - The argument
+     */
+    private static function trimRecord(string $record, string $delimiter): string
+    {
+        if ($delimiter === "\n" && substr($record, -1) === "\r") {
+            return (string)substr($record, 0, -1);
+        }
+        return $record;
+    }
+}
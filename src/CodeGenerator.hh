@@ -0,0 +1,499 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Generates the source of a parser specialized for an option set
+ *
+ * The generated parser looks long labels up in an array of option IDs, so
+ * they're matched exactly rather than by `switch`'s loose comparison (where
+ * `'1'` equals `'01'`), dispatches on the IDs, and converts values inline.
+ * It produces a result class with a typed property for each option instead
+ * of a map. Properties are named for the
+ * first label of each option (e.g. `logFile` for `log-file|l:`). The
+ * parser accepts the same arguments and throws the same exceptions as
+ * `Parser::parse`, except that every alias of an option updates the same
+ * property. Multiple options keep their limit, unique, and interned
+ * settings, and the constraints of the option set are checked inline
+ * after the arguments are read.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class CodeGenerator
+{
+    /**
+     * Creates a new CodeGenerator
+     *
+     * @param $options - The options to parse
+     */
+    public function __construct(private OptionSet $options)
+    {
+    }
+
+    /**
+     * Generates the parser and result classes.
+     *
+     * @param $className - The parser class name; the result class has `Result` appended
+     * @param $namespace - The namespace of the classes, if any
+     * @return - The Hack source
+     * @throws \InvalidArgumentException if the class or namespace name is invalid
+     */
+    public function generate(string $className, string $namespace = ''): string
+    {
+        if (!preg_match('/^[a-zA-Z_][a-zA-Z0-9_]*$/', $className)) {
+            throw new \InvalidArgumentException("Invalid class name: $className");
+        } elseif ($namespace !== '' && !preg_match('/^[a-zA-Z_][a-zA-Z0-9_]*(\\\\[a-zA-Z_][a-zA-Z0-9_]*)*$/', $namespace)) {
+            throw new \InvalidArgumentException("Invalid namespace: $namespace");
+        }
+        $names = $this->getPropertyNames();
+        $out = "<?hh // strict\n// @generated by Cleopatra\\CodeGenerator; do not edit\n";
+        if ($namespace !== '') {
+            $out .= "namespace $namespace;\n";
+        }
+        return $out . "\n" .
+            $this->generateParser($className, $names) . "\n" .
+            $this->generateResult($className . 'Result', $names);
+    }
+
+    /**
+     * Chooses a unique property name for each option.
+     *
+     * @return - The property names by option ID
+     */
+    protected function getPropertyNames(): ImmVector<string>
+    {
+        $used = Set{'program', 'arguments'};
+        $names = Vector{};
+        foreach ($this->options->getOptions() as $option) {
+            $name = lcfirst(str_replace(' ', '', ucwords(str_replace('-', ' ', $option->getName()))));
+            if (ctype_digit($name[0])) {
+                $name = "option$name";
+            }
+            while ($used->contains($name)) {
+                $name .= 'Option';
+            }
+            $used[] = $name;
+            $names[] = $name;
+        }
+        return $names->immutable();
+    }
+
+    /**
+     * Generates the parser class.
+     *
+     * @param $className - The class name
+     * @param $names - The property names by option ID
+     * @return - The Hack source
+     */
+    protected function generateParser(string $className, ImmVector<string> $names): string
+    {
+        $result = $className . 'Result';
+        $withValue = '';
+        $solo = '';
+        $withoutValue = '';
+        $pending = '';
+        $shorts = '';
+        $seen = '';
+        $kept = false;
+        $ids = '';
+        foreach ($this->options->getOptions() as $id => $option) {
+            $flags = $option->getFlags();
+            $name = $names[$id];
+            if (($flags & Option::MULTIPLE) !== 0) {
+                if ($option->isUnique() || $option->isInterned()) {
+                    $seen .= self::indent(2, "\$seen$id = Map{};");
+                }
+                $kept = $kept || $option->getLimit() > 0 || $option->isUnique() || $option->isInterned();
+            }
+            $labels = Vector{};
+            $labels->addAll($option->getLongs());
+            $labels->addAll($option->getShorts());
+            foreach ($labels as $l) {
+                $ids .= self::indent(2, "'$l' => $id,");
+            }
+            $cases = self::indent(6, "case $id:");
+            if (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+                $solo .= $cases;
+            } else {
+                $withValue .= $cases .
+                    self::indent(7, $this->assign($option, $id, $name, '$value')) .
+                    self::indent(7, 'break;');
+            }
+            $withoutValue .= $cases;
+            if (($flags & Option::INCREMENTAL) !== 0) {
+                $withoutValue .= self::indent(7, $this->assign($option, $id, $name, "''"));
+            } elseif (($flags & Option::REQUIRED) !== 0) {
+                $withoutValue .= self::indent(7, "\$pending = $id;") .
+                    self::indent(7, '$pendingName = "--$label";');
+                $pending .= self::indent(5, "case $id:") .
+                    self::indent(6, $this->assign($option, $id, $name, '$arg')) .
+                    self::indent(6, 'break;');
+            } else {
+                $withoutValue .= self::indent(7, $this->assign($option, $id, $name, "''"));
+            }
+            $withoutValue .= self::indent(7, 'break;');
+            foreach ($option->getShorts() as $short) {
+                $shorts .= self::indent(6, "case '$short':");
+                if (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+                    $shorts .= self::indent(7, $this->assign($option, $id, $name, "''"));
+                } else {
+                    $shorts .= self::indent(7, 'if ($i + 1 < $length) {') .
+                        self::indent(8, '$value = (string)substr($arg, $i + 1);') .
+                        self::indent(8, $this->assign($option, $id, $name, '$value')) .
+                        self::indent(8, '$i = $length;');
+                    if (($flags & Option::REQUIRED) !== 0) {
+                        $shorts .= self::indent(7, '} else {') .
+                            self::indent(8, "\$pending = $id;") .
+                            self::indent(8, "\$pendingName = '-$short';");
+                    } else {
+                        $shorts .= self::indent(7, '} else {') .
+                            self::indent(8, $this->assign($option, $id, $name, "''"));
+                    }
+                    $shorts .= self::indent(7, '}');
+                }
+                $shorts .= self::indent(7, 'break;');
+            }
+        }
+        if ($solo !== '') {
+            $withValue .= $solo .
+                self::indent(7, 'throw new \\UnexpectedValueException("Option --$label does not take a value");');
+        }
+        $withValue .= self::indent(6, 'default:') .
+            self::indent(7, 'throw new \\UnexpectedValueException("Unknown option: --$label");');
+        $withoutValue .= self::indent(6, 'default:') .
+            self::indent(7, 'throw new \\UnexpectedValueException("Unknown option: --$label");');
+        $shorts .= self::indent(6, 'default:') .
+            self::indent(7, 'throw new \\UnexpectedValueException(\'Unknown option: -\' . $arg[$i]);');
+        $pendingSwitch = $pending === '' ? '' :
+            self::indent(4, 'switch ($pending) {') . $pending . self::indent(4, '}');
+        $add = '';
+        if ($kept) {
+            $add = "\n" .
+                self::indent(1, 'private static function add<T>(Vector<T> $values, T $value, int $limit, ?Map<arraykey,T> $seen, bool $unique): void') .
+                self::indent(1, '{') .
+                self::indent(2, 'if ($limit > 0 && $values->count() >= $limit) {') .
+                self::indent(3, 'return;') .
+                self::indent(2, '} elseif ($seen !== null) {') .
+                self::indent(3, '$key = \\Cleopatra\\ValueList::key($value);') .
+                self::indent(3, 'if (!$seen->containsKey($key)) {') .
+                self::indent(4, '$seen[$key] = $value;') .
+                self::indent(3, '} elseif ($unique) {') .
+                self::indent(4, 'return;') .
+                self::indent(3, '} else {') .
+                self::indent(4, '$value = $seen[$key];') .
+                self::indent(3, '}') .
+                self::indent(2, '}') .
+                self::indent(2, '$values[] = $value;') .
+                self::indent(1, '}');
+        }
+        $constraints = $this->generateConstraints($names);
+        return <<<HACK
+final class $className
+{
+    private static array<string,int> \$ids = [
+$ids    ];
+
+    public function parse(Traversable<string> \$arguments): $result
+    {
+        \$result = new $result();
+        \$program = false;
+        \$pending = -1;
+        \$pendingName = '';
+        \$literal = false;
+$seen        foreach (\$arguments as \$arg) {
+            if (!\$program) {
+                \$program = true;
+                \$result->program = \$arg;
+            } elseif (\$literal) {
+                \$result->arguments[] = \$arg;
+            } elseif (\$pending !== -1) {
+                if (\$arg !== '' && \$arg[0] === '-') {
+                    throw new \\UnexpectedValueException("Option \$pendingName expects a value");
+                }
+$pendingSwitch                \$pending = -1;
+            } elseif (\$arg === '--') {
+                \$literal = true;
+            } elseif (\$arg === '' || \$arg[0] !== '-') {
+                \$result->arguments[] = \$arg;
+            } elseif (strlen(\$arg) > 1 && \$arg[1] === '-') {
+                \$eq = strpos(\$arg, '=', 2);
+                if (\$eq !== false) {
+                    \$label = (string)substr(\$arg, 2, \$eq - 2);
+                    \$end = strpos(\$arg, '=', \$eq + 1);
+                    \$value = \$end === false ?
+                        (string)substr(\$arg, \$eq + 1) :
+                        (string)substr(\$arg, \$eq + 1, \$end - \$eq - 1);
+                    switch (array_key_exists(\$label, self::\$ids) ? self::\$ids[\$label] : -1) {
+$withValue                    }
+                    continue;
+                }
+                \$label = (string)substr(\$arg, 2);
+                switch (array_key_exists(\$label, self::\$ids) ? self::\$ids[\$label] : -1) {
+$withoutValue                }
+            } else {
+                \$length = strlen(\$arg);
+                if (\$length === 1) {
+                    throw new \\UnexpectedValueException('Unknown option: -');
+                }
+                for (\$i = 1; \$i < \$length; \$i++) {
+                    switch (\$arg[\$i]) {
+$shorts                    }
+                }
+            }
+        }
+        if (!\$program) {
+            throw new \\InvalidArgumentException('Arguments parameter must not be empty');
+        } elseif (\$pending !== -1) {
+            throw new \\UnexpectedValueException("Option \$pendingName expects a value");
+        }
+$constraints        return \$result;
+    }
+$add}
+
+HACK;
+    }
+
+    /**
+     * Generates the statements which check the constraints of the options.
+     *
+     * Each constraint is unrolled into tests of the result properties, and
+     * the messages match those of `ConstraintChecker`.
+     *
+     * @param $names - The property names by option ID
+     * @return - The Hack source, or an empty string if there are no constraints
+     */
+    protected function generateConstraints(ImmVector<string> $names): string
+    {
+        $constraints = $this->options->getConstraints()->getConstraints();
+        if ($constraints->isEmpty()) {
+            return '';
+        }
+        $options = $this->options->getOptions();
+        $used = $id ==> self::isUsed($options[$id], '$result->' . $names[$id]);
+        $label = $id ==> {
+            $name = $options[$id]->getName();
+            return strlen($name) === 1 ? "'-$name'" : "'--$name'";
+        };
+        $out = self::indent(2, '$violations = Vector{};');
+        foreach ($constraints as $constraint) {
+            $ids = $constraint->getIds();
+            $subject = $constraint->getSubject() < 0 ? $ids[0] : $constraint->getSubject();
+            $violation = '$violations[] = new \\Cleopatra\\Diagnostic(\\Cleopatra\\DiagnosticKind::CONSTRAINT, 0, 0, ' .
+                "'" . $options[$subject]->getName() . "', ";
+            switch ($constraint->getKind()) {
+                case Constraint::EXCLUSIVE:
+                    $out .= self::indent(2, '$names = Vector{};');
+                    foreach ($ids as $id) {
+                        $out .= self::indent(2, 'if (' . $used($id) . ') {') .
+                            self::indent(3, '$names[] = ' . $label($id) . ';') .
+                            self::indent(2, '}');
+                    }
+                    $out .= self::indent(2, 'if ($names->count() > 1) {') .
+                        self::indent(3, $violation . "'Options ' . implode(' and ', \$names) . ' cannot be used together');") .
+                        self::indent(2, '}');
+                    break;
+                case Constraint::REQUIRES:
+                    $out .= self::indent(2, 'if (' . $used($subject) . ') {') .
+                        self::indent(3, '$names = Vector{};');
+                    foreach ($ids as $id) {
+                        $out .= self::indent(3, 'if (!(' . $used($id) . ')) {') .
+                            self::indent(4, '$names[] = ' . $label($id) . ';') .
+                            self::indent(3, '}');
+                    }
+                    $out .= self::indent(3, 'if (!$names->isEmpty()) {') .
+                        self::indent(4, $violation . "'Option ' . " . $label($subject) . " . ' requires ' . implode(' and ', \$names));") .
+                        self::indent(3, '}') .
+                        self::indent(2, '}');
+                    break;
+                case Constraint::AT_LEAST_ONE:
+                    $all = implode(', ', $ids->map($id ==> trim($label($id), "'")));
+                    $out .= self::indent(2, 'if (' . implode(' && ', $ids->map($id ==> '!(' . $used($id) . ')')) . ') {') .
+                        self::indent(3, $violation . "'One of $all is required');") .
+                        self::indent(2, '}');
+                    break;
+            }
+        }
+        return $out . self::indent(2, 'if (!$violations->isEmpty()) {') .
+            self::indent(3, 'throw new \\Cleopatra\\ConstraintException($violations->immutable());') .
+            self::indent(2, '}');
+    }
+
+    /**
+     * Generates the result class.
+     *
+     * @param $className - The class name
+     * @param $names - The property names by option ID
+     * @return - The Hack source
+     */
+    protected function generateResult(string $className, ImmVector<string> $names): string
+    {
+        $properties = '';
+        $init = '';
+        $options = '';
+        foreach ($this->options->getOptions() as $id => $option) {
+            $flags = $option->getFlags();
+            $name = $names[$id];
+            $labels = Vector{};
+            $labels->addAll($option->getShorts()->map($l ==> "-$l"));
+            $labels->addAll($option->getLongs()->map($l ==> "--$l"));
+            $doc = str_replace('*/', '* /', implode(' ', $labels) . ': ' .
+                str_replace(PHP_EOL, ' ', $option->getDescription()));
+            $properties .= self::indent(1, "/** $doc */");
+            $key = "'" . $option->getName() . "'";
+            $options .= self::indent(2, 'if (' . self::isUsed($option, "\$this->$name") . ') {');
+            if (($flags & Option::INCREMENTAL) !== 0) {
+                $properties .= self::indent(1, "public int \$$name = 0;");
+                $options .= self::indent(3, "\$options[$key] = \$this->$name;");
+            } elseif (($flags & Option::MULTIPLE) !== 0) {
+                $type = self::typeName($flags, $option->getType());
+                $properties .= self::indent(1, "public Vector<$type> \$$name;");
+                $init .= self::indent(2, "\$this->$name = Vector{};");
+                $options .= self::indent(3, "\$options[$key] = new Vector(\$this->$name);");
+            } elseif (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+                $properties .= self::indent(1, "public bool \$$name = false;");
+                $options .= self::indent(3, "\$options[$key] = true;");
+            } else {
+                $type = self::typeName($flags, $option->getType());
+                $type = $type === 'mixed' ? $type : "?$type";
+                $properties .= self::indent(1, "public $type \$$name = null;");
+                $options .= self::indent(3, "\$options[$key] = \$this->$name;");
+            }
+            $options .= self::indent(2, '}');
+        }
+        return <<<HACK
+final class $className
+{
+    public string \$program = '';
+    public Vector<string> \$arguments;
+$properties
+    public function __construct()
+    {
+        \$this->arguments = Vector{};
+$init    }
+
+    public function getOptions(): ImmMap<string,mixed>
+    {
+        \$options = Map{};
+$options        return \$options->immutable();
+    }
+
+    public function toCommand(): \\Cleopatra\\Command
+    {
+        return new \\Cleopatra\\Command(\$this->program, \$this->getOptions(), \$this->arguments->immutable());
+    }
+}
+
+HACK;
+    }
+
+    /**
+     * Generates the statement which stores a value.
+     *
+     * Values of multiple options with a limit, or which are unique or
+     * interned, are added through the parser's `add` method, which keeps
+     * them the same way `ValueList` does.
+     *
+     * @param $option - The option
+     * @param $id - The option ID
+     * @param $name - The property name
+     * @param $value - The expression of the string value
+     * @return - The Hack statement
+     */
+    protected function assign(Option $option, int $id, string $name, string $value): string
+    {
+        $flags = $option->getFlags();
+        $type = $option->getType();
+        if (($flags & Option::INCREMENTAL) !== 0) {
+            return "\$result->$name++;";
+        }
+        if (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+            $expr = 'true';
+        } else {
+            switch ($flags & Option::TYPE_MASK) {
+                case Option::TYPE_INTEGER:
+                    $expr = "(int)$value";
+                    break;
+                case Option::TYPE_FLOAT:
+                    $expr = "(float)$value";
+                    break;
+                case Option::TYPE_DATE:
+                    $expr = "new \\DateTimeImmutable($value)";
+                    break;
+                default:
+                    $expr = strlen($type) > 1 ?
+                        "\\Cleopatra\\ConverterRegistry::convert('$type', $value)" : $value;
+            }
+        }
+        if (($flags & Option::MULTIPLE) === 0) {
+            return "\$result->$name = $expr;";
+        } elseif ($option->getLimit() === 0 && !$option->isUnique() && !$option->isInterned()) {
+            return "\$result->{$name}[] = $expr;";
+        }
+        $seen = $option->isUnique() || $option->isInterned() ? "\$seen$id" : 'null';
+        return "self::add(\$result->$name, $expr, " . $option->getLimit() . ", $seen, " .
+            ($option->isUnique() ? 'true' : 'false') . ');';
+    }
+
+    /**
+     * Generates the expression which tells whether an option was used.
+     *
+     * @param $option - The option
+     * @param $property - The expression of its result property (e.g. `$this->verbose`)
+     * @return - The Hack expression
+     */
+    private static function isUsed(Option $option, string $property): string
+    {
+        $flags = $option->getFlags();
+        if (($flags & Option::INCREMENTAL) !== 0) {
+            return "$property !== 0";
+        } elseif (($flags & Option::MULTIPLE) !== 0) {
+            return "!{$property}->isEmpty()";
+        } elseif (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+            return $property;
+        }
+        return "$property !== null";
+    }
+
+    /**
+     * Gets the Hack type of option values.
+     *
+     * @param $flags - The option flags
+     * @param $type - The option type (see `Option::getType`)
+     * @return - The type name
+     */
+    private static function typeName(int $flags, string $type): string
+    {
+        if (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+            return 'bool';
+        } elseif (strlen($type) > 1) {
+            return 'mixed';
+        }
+        switch ($flags & Option::TYPE_MASK) {
+            case Option::TYPE_INTEGER:
+                return 'int';
+            case Option::TYPE_FLOAT:
+                return 'float';
+            case Option::TYPE_DATE:
+                return '\\DateTimeImmutable';
+        }
+        return 'string';
+    }
+
+    /**
+     * Indents a line of generated code.
+     *
+     * @param $depth - The number of levels to indent
+     * @param $line - The line
+     * @return - The indented line with a trailing newline
+     */
+    private static function indent(int $depth, string $line): string
+    {
+        return str_repeat('    ', $depth) . $line . "\n";
+    }
+}
@@ -10,11 +10,19 @@ namespace Cleopatra;
 /**
  * A parsed command
  *
+ * Commands created by the `Parser` store their options in an `OptionValues`,
+ * so values can be found by any alias of an option. Commands created with a
+ * plain map only find values by the label used as the key.
+ *
  * @copyright 2016 Appertly contributors
  * @license   MIT
  */
 class Command
 {
+    private ?ImmMap<string,mixed> $options;
+    private ?OptionValues $values;
+    private ImmVector<string> $subcommands;
+
     /**
      * Creates a new Command
      *
@@ -22,8 +30,30 @@ class Command
      * @param $options - The parsed options
      * @param $arguments - The parsed arguments
      */
-    public function __construct(private string $program, private ImmMap<string,mixed> $options, private ImmVector<string> $arguments)
+    public function __construct(private string $program, ImmMap<string,mixed> $options, private ImmVector<string> $arguments)
     {
+        $this->options = $options;
+        $this->subcommands = ImmVector{};
+    }
+
+    /**
+     * Creates a new Command with options stored by ID
+     *
+     * @param $program - The program
+     * @param $values - The parsed options
+     * @param $arguments - The parsed arguments
+     * @param $subcommands - The names of the subcommands invoked, if any
+     * @return - The command
+     */
+    public static function fromValues(string $program, OptionValues $values, ImmVector<string> $arguments, ?ImmVector<string> $subcommands = null): Command
+    {
+        $command = new Command($program, ImmMap{}, $arguments);
+        $command->options = null;
+        $command->values = $values;
+        if ($subcommands !== null) {
+            $command->subcommands = $subcommands;
+        }
+        return $command;
     }
 
     /**
@@ -36,14 +66,178 @@ class Command
         return $this->program;
     }
 
+    /**
+     * Gets the names of the subcommands invoked, outermost first
+     *
+     * @return - The subcommand names (e.g. `ec2`, `start-instances`)
+     */
+    public function getSubcommands(): ImmVector<string>
+    {
+        return $this->subcommands;
+    }
+
     /**
      * Gets the options
      *
+     * The options are keyed by each label typed, so `-e a --exclude b` gives
+     * `e` and `exclude` a value each; see `getMergedOptions` to combine them.
+     *
      * @return - The options
      */
     public function getOptions(): ImmMap<string,mixed>
     {
-        return $this->options;
+        $options = $this->options;
+        if ($options === null) {
+            $values = $this->values;
+            $options = $values === null ? ImmMap{} : $values->toMap();
+            $this->options = $options;
+        }
+        return $options;
+    }
+
+    /**
+     * Gets the options with the values of all the labels of each one merged
+     *
+     * The options are keyed by the first label used for each one. Commands
+     * created with a plain map return the map as-is.
+     *
+     * @return - The options
+     */
+    public function getMergedOptions(): ImmMap<string,mixed>
+    {
+        $values = $this->values;
+        return $values === null ? $this->getOptions() : $values->toMergedMap();
+    }
+
+    /**
+     * Gets the options stored by ID, if the command has them
+     *
+     * @return - The option values or null
+     */
+    public function getValues(): ?OptionValues
+    {
+        return $this->values;
+    }
+
+    /**
+     * Gets the value of an option, converting it if necessary
+     *
+     * @param $label - Any label of the option
+     * @return - The value, or null if the option wasn't used
+     */
+    public function getOption(string $label): mixed
+    {
+        $values = $this->values;
+        return $values === null ? $this->getOptions()->get($label) : $values->get($label);
+    }
+
+    /**
+     * Whether an option was used
+     *
+     * @param $label - Any label of the option
+     * @return - true if the option was used
+     */
+    public function hasOption(string $label): bool
+    {
+        $values = $this->values;
+        return $values === null ? $this->getOptions()->containsKey($label) : $values->has($label);
+    }
+
+    /**
+     * Gets the options as they appeared in the arguments
+     *
+     * If the values were converted while parsing, they're returned as-is.
+     *
+     * @return - The unconverted options
+     */
+    public function getRawOptions(): ImmMap<string,mixed>
+    {
+        $values = $this->values;
+        return $values === null ? $this->getOptions() : $values->toRawMap();
+    }
+
+    /**
+     * Gets the value of an option as an integer
+     *
+     * @param $label - Any label of the option
+     * @param $default - The value if the option wasn't used
+     * @return - The value
+     */
+    public function getInt(string $label, int $default = 0): int
+    {
+        $value = $this->getOption($label);
+        if (is_int($value)) {
+            return $value;
+        }
+        return $value === null ? $default : (int)$value;
+    }
+
+    /**
+     * Gets the value of an option as a float
+     *
+     * @param $label - Any label of the option
+     * @param $default - The value if the option wasn't used
+     * @return - The value
+     */
+    public function getFloat(string $label, float $default = 0.0): float
+    {
+        $value = $this->getOption($label);
+        if (is_float($value)) {
+            return $value;
+        }
+        return $value === null ? $default : (float)$value;
+    }
+
+    /**
+     * Gets the value of an option as a string
+     *
+     * @param $label - Any label of the option
+     * @param $default - The value if the option wasn't used
+     * @return - The value
+     */
+    public function getString(string $label, string $default = ''): string
+    {
+        $value = $this->getOption($label);
+        if (is_string($value)) {
+            return $value;
+        }
+        return $value === null ? $default : (string)$value;
+    }
+
+    /**
+     * Gets the values of an option
+     *
+     * An option that can't be used multiple times has at most one value.
+     *
+     * @param $label - Any label of the option
+     * @return - The values
+     */
+    public function getVector(string $label): ImmVector<mixed>
+    {
+        $value = $this->getOption($label);
+        if ($value instanceof Vector) {
+            return $value->immutable();
+        } elseif ($value instanceof ImmVector) {
+            return $value;
+        }
+        return $value === null ? ImmVector{} : ImmVector{$value};
+    }
+
+    /**
+     * Gets the number of times an option was used
+     *
+     * @param $label - Any label of the option
+     * @return - The count for incremental options, the number of values for multiple options, otherwise 1 or 0
+     */
+    public function getCount(string $label): int
+    {
+        $value = $this->getOption($label);
+        if (is_int($value) && $this->isIncremental($label)) {
+            return $value;
+        } elseif ($value instanceof ConstVector) {
+            return $value->count();
+        }
+        return $value === null ? 0 : 1;
     }
 
     /**
@@ -55,4 +249,21 @@ class Command
     {
         return $this->arguments;
     }
+
+    /**
+     * Whether an option is incremental
+     *
+     * @param $label - Any label of the option
+     * @return - true if the option is known to be incremental; always false for a plain map, which has no option specs
+     */
+    private function isIncremental(string $label): bool
+    {
+        $values = $this->values;
+        if ($values === null) {
+            return false;
+        }
+        $id = $values->getId($label);
+        return $id !== null &&
+            ($values->getOptionSet()->getFlags($id) & Option::INCREMENTAL) !== 0;
+    }
 }
@@ -0,0 +1,146 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * A command with its own options and subcommands
+ *
+ * The options of a node are created by a factory the first time they're
+ * needed, so a program with many subcommands only builds the options of the
+ * subcommands actually invoked. A node accepts its own options plus those of
+ * all its ancestors; a node which only groups subcommands (e.g. `ec2` in
+ * `aws ec2 start-instances`) can have no options of its own.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class CommandNode
+{
+    private Map<string,CommandNode> $children;
+    private ?CommandNode $parent;
+    private ?OptionSet $options;
+    private ?OptionSet $scope;
+
+    /**
+     * Creates a new CommandNode
+     *
+     * @param $factory - Creates the options of this command, or null if it has none of its own
+     * @param $description - A human readable description
+     */
+    public function __construct(private ?(function(): OptionSet) $factory, private string $description = '')
+    {
+        $this->children = Map{};
+    }
+
+    /**
+     * Adds a subcommand.
+     *
+     * @param $name - The subcommand name (e.g. `start-instances`)
+     * @param $child - The subcommand
+     * @return - This node
+     * @throws \InvalidArgumentException if the name is taken or the child already has a parent
+     */
+    public function add(string $name, CommandNode $child): this
+    {
+        if ($name === '' || $name[0] === '-') {
+            throw new \InvalidArgumentException("Invalid subcommand name: $name");
+        } elseif ($this->children->containsKey($name)) {
+            throw new \InvalidArgumentException("Duplicate subcommand: $name");
+        } elseif ($child->parent !== null) {
+            throw new \InvalidArgumentException("Subcommand already has a parent: $name");
+        }
+        $child->parent = $this;
+        $this->children[$name] = $child;
+        return $this;
+    }
+
+    /**
+     * Gets a subcommand by name.
+     *
+     * @param $name - The subcommand name
+     * @return - The subcommand or null
+     */
+    public function getChild(string $name): ?CommandNode
+    {
+        return $this->children->get($name);
+    }
+
+    /**
+     * Gets the subcommands.
+     *
+     * @return - The subcommands by name
+     */
+    public function getChildren(): ImmMap<string,CommandNode>
+    {
+        return $this->children->immutable();
+    }
+
+    /**
+     * Gets the parent command.
+     *
+     * @return - The parent, or null if this is the root
+     */
+    public function getParent(): ?CommandNode
+    {
+        return $this->parent;
+    }
+
+    /**
+     * Gets the description.
+     *
+     * @return - The description
+     */
+    public function getDescription(): string
+    {
+        return $this->description;
+    }
+
+    /**
+     * Gets the options of this command alone, creating them if necessary.
+     *
+     * @return - The options, or null if it has none of its own
+     */
+    public function getOptions(): ?OptionSet
+    {
+        $options = $this->options;
+        $factory = $this->factory;
+        if ($options === null && $factory !== null) {
+            $options = $factory();
+            $this->options = $options;
+        }
+        return $options;
+    }
+
+    /**
+     * Gets the options accepted by this command: those of its ancestors and its own.
+     *
+     * Option IDs of the ancestors are the same in the scope of the child. A
+     * command without options of its own shares the scope of its parent.
+     *
+     * @return - The options
+     * @throws \InvalidArgumentException if any option labels collide with an ancestor, or the root has no options
+     */
+    public function getScope(): OptionSet
+    {
+        $scope = $this->scope;
+        if ($scope === null) {
+            $parent = $this->parent;
+            $options = $this->getOptions();
+            if ($parent === null) {
+                if ($options === null) {
+                    throw new \InvalidArgumentException("The root command must have options");
+                }
+                $scope = $options;
+            } else {
+                $scope = $options === null ? $parent->getScope() : $parent->getScope()->combine($options);
+            }
+            $this->scope = $scope;
+        }
+        return $scope;
+    }
+}
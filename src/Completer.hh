@@ -0,0 +1,245 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Completes partial command lines for shell tab-completion
+ *
+ * Long labels are found with the prefix trie of the option set, which is
+ * built once per set. The scripts from `getScript` call the program back
+ * with `__complete`, the index of the word being completed, and the words;
+ * pass the arguments to `handle` before parsing them.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Completer
+{
+    /**
+     * The argument which asks the program for completions
+     */
+    const string COMMAND = '__complete';
+
+    /**
+     * Creates a new Completer
+     *
+     * @param $options - The options to complete
+     * @param $commands - The root of a tree of subcommands whose scope is `$options`, if any
+     */
+    public function __construct(private OptionSet $options, private ?CommandNode $commands = null)
+    {
+    }
+
+    /**
+     * Creates a new Completer for a tree of subcommands
+     *
+     * @param $root - The root command
+     * @return - The completer
+     */
+    public static function forCommands(CommandNode $root): Completer
+    {
+        return new Completer($root->getScope(), $root);
+    }
+
+    /**
+     * Completes a word on a command line.
+     *
+     * The words before the cursor are read the way `Parser` would read them,
+     * except that unknown options are skipped.
+     *
+     * @param $words - The words on the command line, starting with the program
+     * @param $cursor - The index of the word being completed
+     * @return - The candidates
+     */
+    public function complete(Traversable<string> $words, int $cursor): Completion
+    {
+        $options = $this->options;
+        $node = $this->commands;
+        $pending = null;
+        $literal = false;
+        $word = '';
+        $i = -1;
+        foreach ($words as $arg) {
+            $i++;
+            if ($i >= $cursor) {
+                $word = $arg;
+                break;
+            } elseif ($i === 0 || $literal) {
+                continue;
+            } elseif ($pending !== null) {
+                $pending = null;
+            } elseif ($arg === '--') {
+                $literal = true;
+            } elseif ($arg === '' || $arg[0] !== '-') {
+                $node = $node === null ? null : $node->getChild($arg);
+                if ($node !== null) {
+                    $options = $node->getScope();
+                }
+            } elseif (strlen($arg) > 1 && $arg[1] === '-') {
+                if (strpos($arg, '=') === false) {
+                    $id = $options->getLongId((string)substr($arg, 2));
+                    if ($id !== null && ($options->getFlags($id) & Option::REQUIRED) !== 0) {
+                        $pending = $id;
+                    }
+                }
+            } else {
+                $bundle = self::readBundle($options, $arg);
+                if ($bundle !== null && $bundle[1] === strlen($arg) &&
+                    ($options->getFlags($bundle[0]) & Option::REQUIRED) !== 0) {
+                    $pending = $bundle[0];
+                }
+            }
+        }
+        if ($pending !== null) {
+            return new Completion(ImmMap{}, $options->getOptionById($pending));
+        } elseif ($literal) {
+            return new Completion(ImmMap{});
+        }
+        $candidates = Map{};
+        if ($word === '-') {
+            foreach ($options->getOptions() as $option) {
+                foreach ($option->getShorts() as $o) {
+                    $candidates["-$o"] = $option;
+                }
+            }
+            $word = '--';
+        }
+        if ($word === '' || $word[0] !== '-') {
+            $children = $node === null ? ImmMap{} : $node->getChildren();
+            $names = [];
+            $length = strlen($word);
+            foreach ($children as $name => $child) {
+                if (substr($name, 0, $length) === $word) {
+                    $names[] = $name;
+                }
+            }
+            sort($names, SORT_STRING);
+            foreach ($names as $name) {
+                $candidates[$name] = null;
+            }
+        } elseif (strlen($word) > 1 && $word[1] === '-') {
+            $eq = strpos($word, '=');
+            if ($eq !== false) {
+                $id = $options->getLongId((string)substr($word, 2, $eq - 2));
+                return new Completion(ImmMap{}, $id === null ? null : $options->getOptionById($id));
+            }
+            foreach ($options->getLabelTrie()->find((string)substr($word, 2)) as $label => $id) {
+                $candidates["--$label"] = $options->getOptionById($id);
+            }
+        } else {
+            $bundle = self::readBundle($options, $word);
+            if ($bundle !== null) {
+                $option = $options->getOptionById($bundle[0]);
+                if ($bundle[1] < strlen($word)) {
+                    return new Completion(ImmMap{}, $option);
+                }
+                $candidates[$word] = $option;
+            }
+        }
+        return new Completion($candidates->immutable());
+    }
+
+    /**
+     * Writes completions if the program was called by a completion script.
+     *
+     * @param $arguments - The arguments the program was called with
+     * @param $handle - The stream to write the candidates to, one per line
+     * @return - true if the arguments asked for completions
+     */
+    public function handle(Traversable<string> $arguments, resource $handle): bool
+    {
+        $args = new ImmVector($arguments);
+        if ($args->get(1) !== self::COMMAND) {
+            return false;
+        }
+        $completion = $this->complete($args->skip(3), (int)$args->get(2));
+        foreach ($completion->getCandidates() as $candidate) {
+            fwrite($handle, $candidate . PHP_EOL);
+        }
+        return true;
+    }
+
+    /**
+     * Gets a completion script for a shell.
+     *
+     * @param $shell - The shell: `bash`, `zsh`, or `fish`
+     * @param $program - The name of the program
+     * @return - The script
+     * @throws \InvalidArgumentException if the shell isn't supported
+     */
+    public static function getScript(string $shell, string $program): string
+    {
+        $function = '_' . preg_replace('/[^a-zA-Z0-9_]/', '_', $program) . '_complete';
+        $command = escapeshellarg($program) . ' ' . self::COMMAND;
+        switch ($shell) {
+            case 'bash':
+                // COMP_WORDS is split at `=`, so keep `--opt=value` as one word
+                return "$function() {" . PHP_EOL .
+                    "    local IFS=\$'\\n' cur cword" . PHP_EOL .
+                    "    local -a words" . PHP_EOL .
+                    "    if declare -F _get_comp_words_by_ref >/dev/null; then" . PHP_EOL .
+                    "        _get_comp_words_by_ref -n = -c cur -w words -i cword" . PHP_EOL .
+                    "    else" . PHP_EOL .
+                    "        local line=\"\${COMP_LINE:0:COMP_POINT}\"" . PHP_EOL .
+                    "        IFS=\$' \\t' read -ra words <<< \"\$line\"" . PHP_EOL .
+                    "        [[ -z \"\$line\" || \"\$line\" == *[[:space:]] ]] && words+=('')" . PHP_EOL .
+                    "        cword=\$((\${#words[@]} - 1))" . PHP_EOL .
+                    "        cur=\"\${words[cword]}\"" . PHP_EOL .
+                    "    fi" . PHP_EOL .
+                    "    COMPREPLY=(\$($command \"\$cword\" \"\${words[@]}\" 2>/dev/null))" . PHP_EOL .
+                    "    if [ \${#COMPREPLY[@]} -eq 0 ]; then" . PHP_EOL .
+                    "        [[ \"\$cur\" == --*=* ]] && cur=\"\${cur#*=}\"" . PHP_EOL .
+                    "        COMPREPLY=(\$(compgen -f -- \"\$cur\"))" . PHP_EOL .
+                    "    fi" . PHP_EOL .
+                    "}" . PHP_EOL .
+                    "complete -F $function " . escapeshellarg($program) . PHP_EOL;
+            case 'zsh':
+                return "#compdef $program" . PHP_EOL .
+                    "$function() {" . PHP_EOL .
+                    "    local -a candidates" . PHP_EOL .
+                    "    candidates=(\"\${(@f)\$($command \$((CURRENT - 1)) \"\${words[@]}\" 2>/dev/null)}\")" . PHP_EOL .
+                    "    if [[ -n \"\$candidates\" ]]; then" . PHP_EOL .
+                    "        compadd -a candidates" . PHP_EOL .
+                    "    else" . PHP_EOL .
+                    "        _files" . PHP_EOL .
+                    "    fi" . PHP_EOL .
+                    "}" . PHP_EOL .
+                    "compdef $function " . escapeshellarg($program) . PHP_EOL;
+            case 'fish':
+                return "function $function" . PHP_EOL .
+                    "    set -l words (commandline -opc)" . PHP_EOL .
+                    "    $command (count \$words) \$words (commandline -ct) 2>/dev/null" . PHP_EOL .
+                    "end" . PHP_EOL .
+                    "complete -c " . escapeshellarg($program) . " -a '($function)'" . PHP_EOL;
+            default:
+                throw new \InvalidArgumentException("Unsupported shell: $shell");
+        }
+    }
+
+    /**
+     * Reads a bundle of short options.
+     *
+     * @param $options - The options in scope
+     * @param $arg - The bundle (e.g. `-vvx`)
+     * @return - The ID of the last option read and the offset after it, or null if any are unknown
+     */
+    private static function readBundle(OptionSet $options, string $arg): ?(int, int)
+    {
+        $length = strlen($arg);
+        $id = null;
+        for ($i = 1; $i < $length; $i++) {
+            $id = $options->getShortId(ord($arg[$i]));
+            if ($id === null) {
+                return null;
+            } elseif (($options->getFlags($id) & (Option::REQUIRED | Option::OPTIONAL)) !== 0) {
+                return tuple($id, $i + 1);
+            }
+        }
+        return $id === null ? null : tuple($id, $length);
+    }
+}
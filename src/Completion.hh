@@ -0,0 +1,80 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * The candidates for completing a word on the command line
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Completion
+{
+    /**
+     * Creates a new Completion
+     *
+     * @param $candidates - The options for each candidate, or null if it's a subcommand
+     * @param $valueOption - The option whose value is the word, if any
+     */
+    public function __construct(private ImmMap<string,?Option> $candidates, private ?Option $valueOption = null)
+    {
+    }
+
+    /**
+     * Gets the candidates.
+     *
+     * @return - The candidates (e.g. `--verbose`, `start-instances`)
+     */
+    public function getCandidates(): ImmVector<string>
+    {
+        return $this->candidates->keys();
+    }
+
+    /**
+     * Gets the option a candidate stands for.
+     *
+     * @param $candidate - The candidate
+     * @return - The option, or null if the candidate is a subcommand
+     */
+    public function getOption(string $candidate): ?Option
+    {
+        return $this->candidates->get($candidate);
+    }
+
+    /**
+     * Whether a candidate must be followed by a value.
+     *
+     * @param $candidate - The candidate
+     * @return - true if the candidate is an option with a required value
+     */
+    public function takesValue(string $candidate): bool
+    {
+        $option = $this->candidates->get($candidate);
+        return $option !== null && $option->isRequired();
+    }
+
+    /**
+     * Gets the option whose value is the word being completed.
+     *
+     * @return - The option, or null if the word isn't a value
+     */
+    public function getValueOption(): ?Option
+    {
+        return $this->valueOption;
+    }
+
+    /**
+     * Whether the word being completed is the value of an option.
+     *
+     * @return - true if the word is a value
+     */
+    public function expectsValue(): bool
+    {
+        return $this->valueOption !== null;
+    }
+}
@@ -0,0 +1,90 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Reads option values from INI and JSON files
+ *
+ * Files ending in `.json` are read as JSON; anything else is read as INI.
+ * Nested keys are joined with a dot, so `port` in the `[server]` section of
+ * an INI file, or in the `server` object of a JSON file, is `server.port`.
+ * Lists are kept as vectors. Values are left unconverted.
+ *
+ * Parsed files are cached by path and a hash of their contents, so a file is
+ * only parsed again if it actually changes, even when it is rewritten within
+ * the same second or its modification time is preserved.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ConfigFile
+{
+    private static array<string,Pair<string,ImmMap<string,mixed>>> $cache = [];
+
+    /**
+     * Gets the values in a config file, reading it if necessary.
+     *
+     * @param $path - The path to the file
+     * @return - The values by key
+     * @throws \UnexpectedValueException if the file can't be read or parsed
+     */
+    public static function load(string $path): ImmMap<string,mixed>
+    {
+        clearstatcache(true, $path);
+        $contents = @file_get_contents($path);
+        if (!is_string($contents)) {
+            throw new \UnexpectedValueException("Cannot read config file: $path");
+        }
+        $hash = sha1($contents);
+        $cached = array_key_exists($path, self::$cache) ? self::$cache[$path] : null;
+        if ($cached !== null && $cached[0] === $hash) {
+            return $cached[1];
+        }
+        if (strtolower((string)pathinfo($path, PATHINFO_EXTENSION)) === 'json') {
+            $data = json_decode($contents, true);
+        } else {
+            $data = @parse_ini_string($contents, true, INI_SCANNER_RAW);
+        }
+        if (!is_array($data)) {
+            throw new \UnexpectedValueException("Cannot read config file: $path");
+        }
+        $values = Map{};
+        self::flatten($data, '', $values);
+        $map = $values->immutable();
+        self::$cache[$path] = Pair{$hash, $map};
+        return $map;
+    }
+
+    /**
+     * Forgets every parsed file.
+     */
+    public static function clearCache(): void
+    {
+        self::$cache = [];
+    }
+
+    /**
+     * Flattens nested values into dotted keys.
+     *
+     * @param $data - The nested values
+     * @param $prefix - The key of the values, followed by a dot, or an empty string
+     * @param $values - The map to add the values to
+     */
+    private static function flatten(array<mixed,mixed> $data, string $prefix, Map<string,mixed> $values): void
+    {
+        foreach ($data as $key => $value) {
+            if (!is_array($value)) {
+                $values[$prefix . $key] = $value;
+            } elseif ($value === [] || array_keys($value) === range(0, count($value) - 1)) {
+                $values[$prefix . $key] = new Vector($value);
+            } else {
+                self::flatten($value, $prefix . $key . '.', $values);
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * A rule about which options can be used together
+ *
+ * Constraints refer to options by ID; declare them with
+ * `OptionSet::exclusive`, `OptionSet::requires`, and
+ * `OptionSet::atLeastOne`.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Constraint
+{
+    /**
+     * At most one of the options can be used
+     */
+    const int EXCLUSIVE = 0;
+    /**
+     * If the subject is used, all of the options must be used
+     */
+    const int REQUIRES = 1;
+    /**
+     * At least one of the options must be used
+     */
+    const int AT_LEAST_ONE = 2;
+
+    /**
+     * Creates a new Constraint
+     *
+     * @param $kind - One of the kind constants (e.g. `Constraint::EXCLUSIVE`)
+     * @param $ids - The IDs of the options it applies to
+     * @param $subject - The ID of the option which triggers a `REQUIRES` constraint, or -1
+     */
+    public function __construct(private int $kind, private ImmVector<int> $ids, private int $subject = -1)
+    {
+    }
+
+    /**
+     * Gets the kind of constraint.
+     *
+     * @return - One of the kind constants
+     */
+    public function getKind(): int
+    {
+        return $this->kind;
+    }
+
+    /**
+     * Gets the IDs of the options the constraint applies to.
+     *
+     * @return - The option IDs
+     */
+    public function getIds(): ImmVector<int>
+    {
+        return $this->ids;
+    }
+
+    /**
+     * Gets the ID of the option which triggers a `REQUIRES` constraint.
+     *
+     * @return - The option ID, or -1 for other kinds
+     */
+    public function getSubject(): int
+    {
+        return $this->subject;
+    }
+
+    /**
+     * Gets a copy for options whose IDs are shifted.
+     *
+     * @param $offset - The amount to add to each ID
+     * @return - The new constraint
+     */
+    public function withOffset(int $offset): Constraint
+    {
+        return new Constraint(
+            $this->kind,
+            $this->ids->map($id ==> $id + $offset),
+            $this->subject < 0 ? -1 : $this->subject + $offset
+        );
+    }
+}
@@ -0,0 +1,186 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Checks the options used against a set of constraints
+ *
+ * Each constraint is compiled to a bitmask over option IDs, stored sparsely
+ * as words keyed by their index, so a check costs one pass over the options
+ * used plus one pass over the words of each mask. Every violation is found,
+ * not just the first.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ConstraintChecker
+{
+    /**
+     * The number of option IDs in each mask word
+     */
+    const int WORD_BITS = 32;
+
+    private ImmVector<ImmMap<int,int>> $masks;
+
+    /**
+     * Creates a new ConstraintChecker
+     *
+     * @param $options - The options the constraints refer to
+     * @param $constraints - The constraints
+     */
+    public function __construct(private OptionSet $options, private ImmVector<Constraint> $constraints)
+    {
+        $this->masks = $constraints->map($c ==> self::toMask($c->getIds()));
+    }
+
+    /**
+     * Whether there are no constraints.
+     *
+     * @return - true if there's nothing to check
+     */
+    public function isEmpty(): bool
+    {
+        return $this->constraints->isEmpty();
+    }
+
+    /**
+     * Gets the constraints.
+     *
+     * @return - The constraints
+     */
+    public function getConstraints(): ImmVector<Constraint>
+    {
+        return $this->constraints;
+    }
+
+    /**
+     * Checks the options used.
+     *
+     * @param $used - The IDs of the options used (e.g. `OptionValues::getUsedIds`)
+     * @return - A diagnostic for each constraint broken
+     */
+    public function check(Traversable<int> $used): ImmVector<Diagnostic>
+    {
+        $violations = Vector{};
+        if ($this->constraints->isEmpty()) {
+            return $violations->immutable();
+        }
+        $bits = self::toMask($used);
+        foreach ($this->constraints as $i => $constraint) {
+            $mask = $this->masks[$i];
+            $count = 0;
+            $missing = false;
+            foreach ($mask as $word => $m) {
+                $b = (int)$bits->get($word) & $m;
+                $missing = $missing || $b !== $m;
+                while ($b !== 0) {
+                    $b &= $b - 1;
+                    $count++;
+                }
+            }
+            switch ($constraint->getKind()) {
+                case Constraint::EXCLUSIVE:
+                    if ($count > 1) {
+                        $violations[] = $this->createDiagnostic(
+                            $constraint,
+                            "Options " . $this->describe($constraint->getIds()->filter($id ==> self::has($bits, $id)), ' and ') . " cannot be used together"
+                        );
+                    }
+                    break;
+                case Constraint::REQUIRES:
+                    if ($missing && self::has($bits, $constraint->getSubject())) {
+                        $violations[] = $this->createDiagnostic(
+                            $constraint,
+                            "Option " . $this->describe(ImmVector{$constraint->getSubject()}, '') . " requires " .
+                                $this->describe($constraint->getIds()->filter($id ==> !self::has($bits, $id)), ' and ')
+                        );
+                    }
+                    break;
+                case Constraint::AT_LEAST_ONE:
+                    if ($count === 0) {
+                        $violations[] = $this->createDiagnostic(
+                            $constraint,
+                            "One of " . $this->describe($constraint->getIds(), ', ') . " is required"
+                        );
+                    }
+                    break;
+            }
+        }
+        return $violations->immutable();
+    }
+
+    /**
+     * Checks the options used, throwing if any constraint is broken.
+     *
+     * @param $used - The IDs of the options used
+     * @throws ConstraintException if any constraint is broken
+     */
+    public function validate(Traversable<int> $used): void
+    {
+        $violations = $this->check($used);
+        if (!$violations->isEmpty()) {
+            throw new ConstraintException($violations);
+        }
+    }
+
+    /**
+     * Creates a diagnostic for a broken constraint.
+     *
+     * @param $constraint - The constraint
+     * @param $message - The error message
+     * @return - The diagnostic
+     */
+    private function createDiagnostic(Constraint $constraint, string $message): Diagnostic
+    {
+        $id = $constraint->getSubject() < 0 ? $constraint->getIds()[0] : $constraint->getSubject();
+        return new Diagnostic(DiagnosticKind::CONSTRAINT, 0, 0, $this->options->getOptionById($id)->getName(), $message);
+    }
+
+    /**
+     * Lists options by name.
+     *
+     * @param $ids - The option IDs
+     * @param $glue - The separator
+     * @return - The names, with dashes (e.g. `-q and --verbose`)
+     */
+    private function describe(ImmVector<int> $ids, string $glue): string
+    {
+        return implode($glue, $ids->map($id ==> {
+            $name = $this->options->getOptionById($id)->getName();
+            return strlen($name) === 1 ? "-$name" : "--$name";
+        }));
+    }
+
+    /**
+     * Compiles option IDs into a sparse bitmask.
+     *
+     * @param $ids - The option IDs
+     * @return - The mask words, keyed by word index
+     */
+    private static function toMask(Traversable<int> $ids): ImmMap<int,int>
+    {
+        $mask = Map{};
+        foreach ($ids as $id) {
+            $word = (int)($id / self::WORD_BITS);
+            $mask[$word] = (int)$mask->get($word) | (1 << ($id % self::WORD_BITS));
+        }
+        return $mask->immutable();
+    }
+
+    /**
+     * Whether a bitmask has an option.
+     *
+     * @param $mask - The mask words
+     * @param $id - The option ID
+     * @return - true if the option's bit is set
+     */
+    private static function has(ImmMap<int,int> $mask, int $id): bool
+    {
+        return ((int)$mask->get((int)($id / self::WORD_BITS)) & (1 << ($id % self::WORD_BITS))) !== 0;
+    }
+}
@@ -0,0 +1,39 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Thrown when the options used break any constraints of their option set
+ *
+ * The message has one line for each constraint broken.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ConstraintException extends \UnexpectedValueException
+{
+    /**
+     * Creates a new ConstraintException
+     *
+     * @param $violations - A diagnostic for each constraint broken
+     */
+    public function __construct(private ImmVector<Diagnostic> $violations)
+    {
+        parent::__construct(implode(PHP_EOL, $violations->map($v ==> $v->getMessage())));
+    }
+
+    /**
+     * Gets the constraints broken.
+     *
+     * @return - A diagnostic for each constraint broken
+     */
+    public function getViolations(): ImmVector<Diagnostic>
+    {
+        return $this->violations;
+    }
+}
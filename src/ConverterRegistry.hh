@@ -0,0 +1,228 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Named value converters that option specs can refer to
+ *
+ * A spec names its type after the colons (e.g. `s|size:bytes` or
+ * `timeout::duration`), and each `Option` looks up its converter once when
+ * it's created. Converters throw `\UnexpectedValueException` for values
+ * they can't convert.
+ *
+ * The built-in types are `s`, `i`, `f`, and `d` (string, integer, float, and
+ * date), plus:
+ * - `bytes`: a size like `512`, `10K`, `1.5G`, or `2TiB`, as an integer number of bytes (1K is 1024)
+ * - `duration`: a duration like `90s`, `1h30m`, or `250ms`, as a float number of seconds
+ * - `path`: the path of an existing file or directory, made absolute
+ * - `iso8601`: an ISO-8601 date, in UTC unless it has an offset (see `DateConverter`)
+ * - `epoch`: a Unix timestamp, in UTC
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ConverterRegistry
+{
+    private static array<string,(function(mixed): mixed)> $converters = [];
+
+    /**
+     * Registers a converter.
+     *
+     * @param $name - The type name, which must start with a letter and have at least two characters
+     * @param $converter - Converts a value, or throws `\UnexpectedValueException`
+     * @throws \InvalidArgumentException if the name is invalid or a built-in type
+     */
+    public static function register(string $name, (function(mixed): mixed) $converter): void
+    {
+        self::init();
+        if (!preg_match('/^[a-zA-Z][a-zA-Z0-9_\-]+$/', $name)) {
+            throw new \InvalidArgumentException("Invalid value type name: $name");
+        } elseif (in_array($name, ['bytes', 'duration', 'path', 'iso8601', 'epoch'], true)) {
+            throw new \InvalidArgumentException("Cannot replace a built-in value type: $name");
+        }
+        self::$converters[$name] = $converter;
+    }
+
+    /**
+     * Registers a type whose values must be one of a set of strings.
+     *
+     * @param $name - The type name
+     * @param $values - The allowed values
+     * @throws \InvalidArgumentException if the name is invalid or a built-in type
+     */
+    public static function registerEnum(string $name, Traversable<string> $values): void
+    {
+        $allowed = new ImmSet($values);
+        self::register($name, $value ==> {
+            $value = (string)$value;
+            if (!$allowed->contains($value)) {
+                throw new \UnexpectedValueException("Invalid $name: $value (expected one of " . implode(', ', $allowed) . ")");
+            }
+            return $value;
+        });
+    }
+
+    /**
+     * Registers a type whose values must match a regular expression.
+     *
+     * @param $name - The type name
+     * @param $pattern - The PCRE pattern (e.g. `/^\d+\.\d+\.\d+$/`)
+     * @throws \InvalidArgumentException if the name is invalid or a built-in type
+     */
+    public static function registerPattern(string $name, string $pattern): void
+    {
+        self::register($name, $value ==> {
+            $value = (string)$value;
+            if (!preg_match($pattern, $value)) {
+                throw new \UnexpectedValueException("Invalid $name: $value");
+            }
+            return $value;
+        });
+    }
+
+    /**
+     * Registers a type whose values are dates in one format.
+     *
+     * Unlike `d`, values must match the format exactly and don't depend on
+     * the default timezone. Repeated values are converted once.
+     *
+     * @param $name - The type name
+     * @param $format - `DateConverter::ISO8601`, `DateConverter::EPOCH`, or a `createFromFormat` pattern (e.g. `d/m/Y`)
+     * @param $timezone - The timezone of dates without an offset
+     * @throws \InvalidArgumentException if the name is invalid or a built-in type, or the timezone is unknown
+     */
+    public static function registerDate(string $name, string $format, string $timezone = 'UTC'): void
+    {
+        $converter = new DateConverter($format, $timezone);
+        self::register($name, $value ==> $converter->convert($value));
+    }
+
+    /**
+     * Whether a type is registered.
+     *
+     * @param $name - The type name
+     * @return - true if the type is registered
+     */
+    public static function has(string $name): bool
+    {
+        self::init();
+        return array_key_exists($name, self::$converters);
+    }
+
+    /**
+     * Gets the converter of a type.
+     *
+     * @param $name - The type name
+     * @return - The converter
+     * @throws \InvalidArgumentException if the type isn't registered
+     */
+    public static function get(string $name): (function(mixed): mixed)
+    {
+        self::init();
+        if (!array_key_exists($name, self::$converters)) {
+            throw new \InvalidArgumentException("Unknown value type: $name");
+        }
+        return self::$converters[$name];
+    }
+
+    /**
+     * Converts a value.
+     *
+     * @param $name - The type name
+     * @param $value - The value
+     * @return - The converted value
+     * @throws \InvalidArgumentException if the type isn't registered
+     * @throws \UnexpectedValueException if the value can't be converted
+     */
+    public static function convert(string $name, mixed $value): mixed
+    {
+        $converter = self::get($name);
+        return $converter($value);
+    }
+
+    /**
+     * Registers the built-in types the first time the registry is used.
+     */
+    private static function init(): void
+    {
+        if (!empty(self::$converters)) {
+            return;
+        }
+        self::$converters = [
+            's' => $value ==> (string)$value,
+            'i' => $value ==> (int)$value,
+            'f' => $value ==> (float)$value,
+            'd' => $value ==> new \DateTimeImmutable((string)$value),
+            'bytes' => $value ==> self::toBytes((string)$value),
+            'duration' => $value ==> self::toSeconds((string)$value),
+            'path' => $value ==> self::toPath((string)$value),
+        ];
+        foreach ([DateConverter::ISO8601, DateConverter::EPOCH] as $format) {
+            $converter = new DateConverter($format);
+            self::$converters[$format] = $value ==> $converter->convert($value);
+        }
+    }
+
+    /**
+     * Converts a size to bytes.
+     *
+     * @param $value - The size (e.g. `10G`)
+     * @return - The number of bytes
+     * @throws \UnexpectedValueException if the size is invalid
+     */
+    private static function toBytes(string $value): int
+    {
+        $matches = [];
+        if (!preg_match('/^\s*(\d+(?:\.\d+)?)\s*(?:([KMGTP])(?:i?B)?|B)?\s*$/i', $value, $matches)) {
+            throw new \UnexpectedValueException("Invalid byte size: $value");
+        }
+        $unit = array_key_exists(2, $matches) ? strtoupper($matches[2]) : '';
+        $power = $unit === '' ? 0 : (int)strpos('KMGTP', $unit) + 1;
+        return (int)round((float)$matches[1] * pow(1024, $power));
+    }
+
+    /**
+     * Converts a duration to seconds.
+     *
+     * @param $value - The duration (e.g. `1h30m`)
+     * @return - The number of seconds
+     * @throws \UnexpectedValueException if the duration is invalid
+     */
+    private static function toSeconds(string $value): float
+    {
+        $units = ['ms' => 0.001, 's' => 1.0, 'm' => 60.0, 'h' => 3600.0, 'd' => 86400.0, 'w' => 604800.0];
+        $matches = [];
+        $count = preg_match_all('/(\d+(?:\.\d+)?)(ms|s|m|h|d|w)/A', $value, $matches, PREG_SET_ORDER);
+        $seconds = 0.0;
+        $length = 0;
+        foreach ($matches as $match) {
+            $seconds += (float)$match[1] * $units[$match[2]];
+            $length += strlen($match[0]);
+        }
+        if ($count === 0 || $length !== strlen($value)) {
+            throw new \UnexpectedValueException("Invalid duration: $value");
+        }
+        return $seconds;
+    }
+
+    /**
+     * Resolves the path of an existing file or directory.
+     *
+     * @param $value - The path
+     * @return - The absolute path
+     * @throws \UnexpectedValueException if nothing exists at the path
+     */
+    private static function toPath(string $value): string
+    {
+        $path = $value === '' ? false : realpath($value);
+        if (!is_string($path)) {
+            throw new \UnexpectedValueException("No such file or directory: $value");
+        }
+        return $path;
+    }
+}
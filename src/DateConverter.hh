@@ -0,0 +1,182 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Converts values in one date format to `DateTimeImmutable`
+ *
+ * The format is picked once, when the converter is created: `ISO8601` and
+ * `EPOCH` are read with a regular expression and an exact
+ * `createFromFormat` call, and anything else is used as a `createFromFormat`
+ * pattern. Custom patterns are reset to the Unix epoch before they're read
+ * (as if they started with `!`) unless they contain `!` or `|`, so the same
+ * value always gives the same date. Dates without an offset are in the
+ * converter's timezone, and epoch timestamps are moved into it.
+ *
+ * Dates are immutable, so repeated values share one converted date. The
+ * cache holds a limited number of values; the oldest are dropped first.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class DateConverter
+{
+    /**
+     * ISO-8601 dates (e.g. `2016-04-01`, `2016-04-01T12:30:00Z`, or `2016-04-01 12:30:00.5+02:00`)
+     */
+    const string ISO8601 = 'iso8601';
+    /**
+     * Unix timestamps in seconds (e.g. `1459513800` or `1459513800.25`)
+     */
+    const string EPOCH = 'epoch';
+
+    private \DateTimeZone $timezone;
+    private (function(string): ?\DateTimeImmutable) $reader;
+    private array<string,\DateTimeImmutable> $cache = [];
+
+    /**
+     * Creates a new DateConverter
+     *
+     * @param $format - `ISO8601`, `EPOCH`, or a `createFromFormat` pattern
+     * @param $timezone - The timezone name (e.g. `UTC` or `Europe/Paris`)
+     * @param $cacheLimit - The maximum number of values to cache; zero disables the cache
+     * @throws \InvalidArgumentException if the format is empty or the timezone is unknown
+     */
+    public function __construct(private string $format, string $timezone = 'UTC', private int $cacheLimit = 1024)
+    {
+        if ($format === '') {
+            throw new \InvalidArgumentException("Date format must not be empty");
+        }
+        try {
+            $this->timezone = new \DateTimeZone($timezone);
+        } catch (\Exception $e) {
+            throw new \InvalidArgumentException("Unknown timezone: $timezone", 0, $e);
+        }
+        $this->cacheLimit = max(0, $cacheLimit);
+        $this->reader = $this->compile();
+    }
+
+    /**
+     * Gets the format.
+     *
+     * @return - `ISO8601`, `EPOCH`, or a `createFromFormat` pattern
+     */
+    public function getFormat(): string
+    {
+        return $this->format;
+    }
+
+    /**
+     * Gets the timezone.
+     *
+     * @return - The timezone of dates without an offset
+     */
+    public function getTimezone(): \DateTimeZone
+    {
+        return $this->timezone;
+    }
+
+    /**
+     * Converts a value.
+     *
+     * @param $value - The value (e.g. `2016-04-01`)
+     * @return - The date
+     * @throws \UnexpectedValueException if the value isn't in the format
+     */
+    public function convert(mixed $value): \DateTimeImmutable
+    {
+        $value = (string)$value;
+        if (array_key_exists($value, $this->cache)) {
+            return $this->cache[$value];
+        }
+        $reader = $this->reader;
+        $date = $reader($value);
+        if ($date === null) {
+            throw new \UnexpectedValueException("Invalid date: $value (expected " . $this->format . ")");
+        }
+        if (count($this->cache) >= $this->cacheLimit) {
+            foreach ($this->cache as $k => $v) {
+                unset($this->cache[$k]);
+                break;
+            }
+        }
+        if ($this->cacheLimit > 0) {
+            $this->cache[$value] = $date;
+        }
+        return $date;
+    }
+
+    /**
+     * Creates the function which reads values in the format.
+     *
+     * @return - The reader, which returns null for invalid values
+     */
+    private function compile(): (function(string): ?\DateTimeImmutable)
+    {
+        $timezone = $this->timezone;
+        switch ($this->format) {
+            case self::ISO8601:
+                return $value ==> {
+                    $m = [];
+                    if (!preg_match('/^(\d{4}-\d{2}-\d{2})(?:[T ](\d{2}:\d{2})(:\d{2})?(?:[.,](\d{1,6})\d*)?)?(Z|[+\-]\d{2}(?::?\d{2})?)?$/i', $value, $m)) {
+                        return null;
+                    }
+                    $m = array_pad($m, 6, '');
+                    $time = ($m[2] === '' ? '00:00' : $m[2]) . ($m[3] === '' ? ':00' : $m[3]) . '.' . str_pad($m[4], 6, '0');
+                    $offset = strtoupper($m[5]);
+                    if ($offset === '') {
+                        return self::create('!Y-m-d H:i:s.u', "{$m[1]} $time", $timezone);
+                    } elseif ($offset === 'Z') {
+                        $offset = '+00:00';
+                    } elseif (strlen($offset) === 3) {
+                        $offset .= ':00';
+                    } elseif (strlen($offset) === 5) {
+                        $offset = substr($offset, 0, 3) . ':' . substr($offset, 3);
+                    }
+                    return self::create('!Y-m-d H:i:s.uP', "{$m[1]} $time$offset", $timezone);
+                };
+            case self::EPOCH:
+                return $value ==> {
+                    $m = [];
+                    if (!preg_match('/^(-?\d+)(?:\.(\d{1,6})\d*)?$/', $value, $m)) {
+                        return null;
+                    }
+                    $m = array_pad($m, 3, '');
+                    $seconds = $m[1];
+                    $micro = (int)str_pad($m[2], 6, '0');
+                    if ($micro > 0 && $seconds[0] === '-') {
+                        // the fraction is added to the seconds, so count back from the second before
+                        $seconds = (string)((int)$seconds - 1);
+                        $micro = 1000000 - $micro;
+                    }
+                    $date = self::create('U.u', $seconds . '.' . str_pad((string)$micro, 6, '0', STR_PAD_LEFT), $timezone);
+                    return $date === null ? null : $date->setTimezone($timezone);
+                };
+        }
+        $format = strpbrk($this->format, '!|') === false ? '!' . $this->format : $this->format;
+        return $value ==> self::create($format, $value, $timezone);
+    }
+
+    /**
+     * Reads a date with `createFromFormat`, rejecting values it had to adjust.
+     *
+     * @param $format - The `createFromFormat` pattern
+     * @param $value - The value
+     * @param $timezone - The timezone of values without an offset
+     * @return - The date, or null if the value doesn't match
+     */
+    private static function create(string $format, string $value, \DateTimeZone $timezone): ?\DateTimeImmutable
+    {
+        $date = \DateTimeImmutable::createFromFormat($format, $value, $timezone);
+        if (!($date instanceof \DateTimeImmutable)) {
+            return null;
+        }
+        $errors = \DateTimeImmutable::getLastErrors();
+        return is_array($errors) && $errors['warning_count'] > 0 ? null : $date;
+    }
+}
@@ -0,0 +1,80 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * A parse error found without throwing an exception
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Diagnostic
+{
+    /**
+     * Creates a new Diagnostic
+     *
+     * @param $kind - The kind of error
+     * @param $index - The index of the argument with the error
+     * @param $offset - The byte offset of the error in the argument
+     * @param $label - The option label, if any
+     * @param $message - The message the `Parser` would have thrown
+     */
+    public function __construct(private DiagnosticKind $kind, private int $index, private int $offset, private string $label, private string $message)
+    {
+    }
+
+    /**
+     * Gets the kind of error.
+     *
+     * @return - The kind
+     */
+    public function getKind(): DiagnosticKind
+    {
+        return $this->kind;
+    }
+
+    /**
+     * Gets the index of the argument with the error.
+     *
+     * @return - The index, where the program is zero; also zero for a broken constraint
+     */
+    public function getIndex(): int
+    {
+        return $this->index;
+    }
+
+    /**
+     * Gets the byte offset of the error in the argument.
+     *
+     * @return - The offset (e.g. 2 for the `x` in `-vxq`)
+     */
+    public function getOffset(): int
+    {
+        return $this->offset;
+    }
+
+    /**
+     * Gets the option label.
+     *
+     * @return - The label as typed, without dashes, or an empty string
+     */
+    public function getLabel(): string
+    {
+        return $this->label;
+    }
+
+    /**
+     * Gets the error message.
+     *
+     * @return - The message
+     */
+    public function getMessage(): string
+    {
+        return $this->message;
+    }
+}
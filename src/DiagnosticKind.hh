@@ -0,0 +1,25 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * The kinds of parse errors
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+enum DiagnosticKind : int
+{
+    NO_ARGUMENTS = 0;
+    UNKNOWN_OPTION = 1;
+    AMBIGUOUS_OPTION = 2;
+    MISSING_VALUE = 3;
+    UNEXPECTED_VALUE = 4;
+    CONSTRAINT = 5;
+    INVALID_VALUE = 6;
+}
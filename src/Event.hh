@@ -0,0 +1,105 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Something encountered while parsing arguments
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class Event
+{
+    private mixed $value;
+    private bool $converted;
+
+    /**
+     * Creates a new Event
+     *
+     * @param $type - The type of event
+     * @param $raw - The program, argument, subcommand, or unconverted option value
+     * @param $label - The option label as typed, if any
+     * @param $id - The option ID, if any
+     * @param $option - The option which converts the value, if any
+     */
+    public function __construct(private EventType $type, private mixed $raw = null, private string $label = '', private ?int $id = null, private ?Option $option = null)
+    {
+        $this->value = $raw;
+        $this->converted = $option === null;
+    }
+
+    /**
+     * Gets the type of event
+     *
+     * @return - The event type
+     */
+    public function getType(): EventType
+    {
+        return $this->type;
+    }
+
+    /**
+     * Gets the value
+     *
+     * For `PROGRAM`, `ARGUMENT`, and `SUBCOMMAND` events this is the string
+     * argument. For `OPTION` events this is the value converted by
+     * `Option::parse`, or the running count of the label as typed for
+     * incremental options. The value is converted the first time it's requested.
+     *
+     * @return - The value
+     */
+    public function getValue(): mixed
+    {
+        $option = $this->option;
+        if (!$this->converted && $option !== null) {
+            $this->converted = true;
+            $this->value = $option->parse($this->raw);
+        }
+        return $this->value;
+    }
+
+    /**
+     * Gets the option which converts the value
+     *
+     * @return - The option, or null if this isn't an option event
+     */
+    public function getOption(): ?Option
+    {
+        return $this->option;
+    }
+
+    /**
+     * Gets the value as it appeared in the arguments
+     *
+     * @return - The unconverted value
+     */
+    public function getRawValue(): mixed
+    {
+        return $this->raw;
+    }
+
+    /**
+     * Gets the option label as typed (e.g. `v` or `verbose`)
+     *
+     * @return - The label, or an empty string if this isn't an option event
+     */
+    public function getLabel(): string
+    {
+        return $this->label;
+    }
+
+    /**
+     * Gets the ID of the option within its `OptionSet`
+     *
+     * @return - The option ID, or null if this isn't an option event
+     */
+    public function getOptionId(): ?int
+    {
+        return $this->id;
+    }
+}
@@ -0,0 +1,24 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * The kinds of parse events
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+enum EventType : int
+{
+    PROGRAM = 0;
+    OPTION = 1;
+    ARGUMENT = 2;
+    END_OF_OPTIONS = 3;
+    SUBCOMMAND = 4;
+    ERROR = 5;
+}
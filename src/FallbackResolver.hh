@@ -0,0 +1,218 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Fills in options missing from the command line
+ *
+ * Each option can have an environment variable, a config key, and a default.
+ * An option given on the command line keeps its value; otherwise the first of
+ * its environment variable, its key in the config files (in the order they
+ * were added), and its default is used. Fallback values are converted with
+ * `Option::parse` like any other, and config files are only read if an
+ * option needs them.
+ *
+ * An option without a value (e.g. `q|quiet`) is only set by a fallback that
+ * reads as true (e.g. `1`, `true`, `yes`, or `on`).
+ *
+ * The constraints of the option set are checked once the fallbacks are
+ * filled in, so an option set by one counts; parse with
+ * `Parser::DEFER_CONSTRAINTS` so the parser doesn't check them first. An
+ * option exclusive with one used on the command line gets no fallback.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class FallbackResolver
+{
+    private Map<int,string> $env;
+    private Map<int,string> $keys;
+    private Map<int,mixed> $defaults;
+    private Vector<string> $files;
+
+    /**
+     * Creates a new FallbackResolver
+     *
+     * @param $options - The options whose fallbacks are declared
+     */
+    public function __construct(private OptionSet $options)
+    {
+        $this->env = Map{};
+        $this->keys = Map{};
+        $this->defaults = Map{};
+        $this->files = Vector{};
+    }
+
+    /**
+     * Declares the environment variable of an option.
+     *
+     * @param $label - Any label of the option
+     * @param $name - The variable name (e.g. `APP_PROFILE`)
+     * @return - This resolver
+     * @throws \InvalidArgumentException if no option has the label
+     */
+    public function env(string $label, string $name): this
+    {
+        $this->env[$this->getId($label)] = $name;
+        return $this;
+    }
+
+    /**
+     * Declares the config key of an option.
+     *
+     * @param $label - Any label of the option
+     * @param $key - The key, with nested keys joined by dots (e.g. `server.port`)
+     * @return - This resolver
+     * @throws \InvalidArgumentException if no option has the label
+     */
+    public function config(string $label, string $key): this
+    {
+        $this->keys[$this->getId($label)] = $key;
+        return $this;
+    }
+
+    /**
+     * Declares the default of an option.
+     *
+     * @param $label - Any label of the option
+     * @param $value - The unconverted value (e.g. `'10'` or `'now'`)
+     * @return - This resolver
+     * @throws \InvalidArgumentException if no option has the label
+     */
+    public function defaultValue(string $label, mixed $value): this
+    {
+        $this->defaults[$this->getId($label)] = $value;
+        return $this;
+    }
+
+    /**
+     * Adds a config file.
+     *
+     * Files that don't exist are skipped.
+     *
+     * @param $path - The path to an INI or JSON file (see `ConfigFile`)
+     * @return - This resolver
+     */
+    public function addConfigFile(string $path): this
+    {
+        $this->files[] = $path;
+        return $this;
+    }
+
+    /**
+     * Gets a command with the fallbacks of any options it doesn't have.
+     *
+     * @param $command - A command created by the `Parser`
+     * @return - The new command
+     * @throws \InvalidArgumentException if the command doesn't store its options by ID
+     * @throws \UnexpectedValueException if a config file can't be parsed
+     * @throws ConstraintException if the options used, with their fallbacks, break any constraints
+     */
+    public function resolve(Command $command): Command
+    {
+        $values = $command->getValues();
+        if ($values === null) {
+            throw new \InvalidArgumentException("The command must be created by a Parser");
+        }
+        $constraints = $values->getOptionSet()->getConstraints();
+        $excluded = Set{};
+        foreach ($constraints->getConstraints() as $constraint) {
+            if ($constraint->getKind() === Constraint::EXCLUSIVE &&
+                $constraint->getIds()->filter($id ==> $values->isUsed($id))->count() > 0) {
+                $excluded->addAll($constraint->getIds());
+            }
+        }
+        $configs = null;
+        $fallbacks = Map{};
+        $count = $values->getOptionSet()->count();
+        foreach ($this->options->getOptions() as $id => $option) {
+            if ($id >= $count) {
+                break;
+            } elseif ($values->isUsed($id) || $excluded->contains($id)) {
+                continue;
+            }
+            $value = null;
+            $name = $this->env->get($id);
+            if ($name !== null) {
+                $env = getenv($name);
+                $value = is_string($env) ? $env : null;
+            }
+            $key = $this->keys->get($id);
+            if ($value === null && $key !== null) {
+                if ($configs === null) {
+                    $configs = $this->loadConfigs();
+                }
+                foreach ($configs as $config) {
+                    if ($config->containsKey($key)) {
+                        $value = $config[$key];
+                        break;
+                    }
+                }
+            }
+            if ($value === null) {
+                $value = $this->defaults->get($id);
+            }
+            if ($value === null) {
+                continue;
+            } elseif ($option->isSolo() && !$option->isIncremental()) {
+                if (!filter_var($value, FILTER_VALIDATE_BOOLEAN)) {
+                    continue;
+                }
+            } elseif ($option->isMultiple() && !($value instanceof Vector)) {
+                $value = Vector{$value};
+            } elseif (!$option->isMultiple() && $value instanceof Vector) {
+                throw new \UnexpectedValueException("Option " . $option->getName() . " takes a single value");
+            }
+            $fallbacks[$id] = $value;
+        }
+        if ($fallbacks->isEmpty()) {
+            $constraints->validate($values->getUsedIds());
+            return $command;
+        }
+        $values = $values->withFallbacks($fallbacks);
+        $constraints->validate($values->getUsedIds());
+        return Command::fromValues(
+            $command->getProgram(),
+            $values,
+            $command->getArguments(),
+            $command->getSubcommands()
+        );
+    }
+
+    /**
+     * Reads the config files that exist.
+     *
+     * @return - The values in each file
+     */
+    private function loadConfigs(): Vector<ImmMap<string,mixed>>
+    {
+        $configs = Vector{};
+        foreach ($this->files as $path) {
+            if (is_file($path)) {
+                $configs[] = ConfigFile::load($path);
+            }
+        }
+        return $configs;
+    }
+
+    /**
+     * Gets the ID of an option.
+     *
+     * @param $label - Any label of the option
+     * @return - The option ID
+     * @throws \InvalidArgumentException if no option has the label
+     */
+    private function getId(string $label): int
+    {
+        $id = $this->options->getLongId($label);
+        if ($id === null) {
+            throw new \InvalidArgumentException("Unknown option: $label");
+        }
+        return $id;
+    }
+}
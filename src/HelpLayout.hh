@@ -0,0 +1,186 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * The help text layout of an option set
+ *
+ * The label column is computed once when the layout is created, and the
+ * wrapped text is computed once for each width it's rendered at. Rendering
+ * writes one entry at a time, so help for a large set can be sent to a
+ * stream without building it as a single string.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class HelpLayout
+{
+    /**
+     * The width used when the terminal width can't be detected
+     */
+    const int DEFAULT_WIDTH = 80;
+
+    private ImmVector<string> $labels;
+    private ImmVector<string> $descriptions;
+    private int $indent;
+    private ImmVector<Pair<string,ImmVector<int>>> $sections;
+    private Map<int,ImmVector<string>> $entries;
+
+    /**
+     * Creates a new HelpLayout
+     *
+     * @param $options - The options to lay out
+     */
+    public function __construct(private OptionSet $options)
+    {
+        $labels = Vector{};
+        $descriptions = Vector{};
+        $ids = Vector{};
+        $indent = 0;
+        foreach ($options->getOptions() as $id => $option) {
+            $key = ' ';
+            foreach ($option->getShorts() as $o) {
+                $key .= " -$o";
+            }
+            foreach ($option->getLongs() as $o) {
+                $key .= " --$o";
+            }
+            $key .= '  ';
+            $labels[] = $key;
+            $descriptions[] = $option->getDescription();
+            $ids[] = $id;
+            $indent = max($indent, strlen($key));
+        }
+        $this->indent = $indent;
+        $this->labels = $labels->map($key ==> str_pad($key, $indent))->immutable();
+        $this->descriptions = $descriptions->immutable();
+        $this->sections = ImmVector{Pair{'', $ids->immutable()}};
+        $this->entries = Map{};
+    }
+
+    /**
+     * Gets a layout that groups the options into titled sections.
+     *
+     * Options not listed in any section come first, without a title. The
+     * label column is shared with this layout.
+     *
+     * @param $sections - The labels of the options in each section, keyed by title
+     * @return - The new layout
+     * @throws \InvalidArgumentException if a label is unknown or listed twice
+     */
+    public function withSections(KeyedTraversable<string,Traversable<string>> $sections): HelpLayout
+    {
+        $listed = Vector{};
+        $listed->resize($this->labels->count(), false);
+        $titled = Vector{};
+        foreach ($sections as $title => $labels) {
+            $ids = Vector{};
+            foreach ($labels as $label) {
+                $id = $this->options->getLongId($label);
+                if ($id === null) {
+                    throw new \InvalidArgumentException("Unknown option: $label");
+                } elseif ($listed[$id]) {
+                    throw new \InvalidArgumentException("Option is already in a section: $label");
+                }
+                $listed[$id] = true;
+                $ids[] = $id;
+            }
+            $titled[] = Pair{$title, $ids->immutable()};
+        }
+        $rest = Vector{};
+        foreach ($listed as $id => $used) {
+            if (!$used) {
+                $rest[] = $id;
+            }
+        }
+        $all = Vector{};
+        if (!$rest->isEmpty()) {
+            $all[] = Pair{'', $rest->immutable()};
+        }
+        $all->addAll($titled);
+        $layout = clone $this;
+        $layout->sections = $all->immutable();
+        $layout->entries = Map{};
+        return $layout;
+    }
+
+    /**
+     * Gets the terminal width from the `COLUMNS` environment variable.
+     *
+     * @return - The width, or `DEFAULT_WIDTH` if it isn't set
+     */
+    public static function detectWidth(): int
+    {
+        $columns = getenv('COLUMNS');
+        if (is_string($columns) && ctype_digit($columns) && (int)$columns > 0) {
+            return (int)$columns;
+        }
+        return self::DEFAULT_WIDTH;
+    }
+
+    /**
+     * Writes the help text to a stream.
+     *
+     * @param $handle - The stream
+     * @param $width - The number of columns, or zero to detect it
+     */
+    public function write(resource $handle, int $width = 0): void
+    {
+        foreach ($this->getEntries($width) as $entry) {
+            fwrite($handle, $entry);
+        }
+    }
+
+    /**
+     * Gets the help text as a string.
+     *
+     * @param $width - The number of columns, or zero to detect it
+     * @return - The help text
+     */
+    public function toString(int $width = 0): string
+    {
+        return implode('', $this->getEntries($width));
+    }
+
+    /**
+     * Gets the rendered entries for a width, rendering them if necessary.
+     *
+     * Text is wrapped one column short of the width so the cursor doesn't
+     * wrap on terminals that move it to the next line at the last column.
+     *
+     * @param $width - The number of columns, or zero to detect it
+     * @return - The section titles and option entries, in order
+     */
+    private function getEntries(int $width): ImmVector<string>
+    {
+        if ($width < 1) {
+            $width = self::detectWidth();
+        }
+        $entries = $this->entries->get($width);
+        if ($entries !== null) {
+            return $entries;
+        }
+        $wrap = max(1, $width - 1 - $this->indent);
+        $newline = str_pad(PHP_EOL, $this->indent + 1);
+        $out = Vector{};
+        foreach ($this->sections as $i => $section) {
+            if ($section[0] !== '') {
+                $out[] = ($i > 0 ? PHP_EOL : '') . $section[0] . ':' . PHP_EOL;
+            }
+            foreach ($section[1] as $id) {
+                $out[] = $this->labels[$id] .
+                    str_replace(PHP_EOL, $newline,
+                        wordwrap($this->descriptions[$id], $wrap, PHP_EOL)
+                    ) . PHP_EOL;
+            }
+        }
+        $entries = $out->immutable();
+        $this->entries[$width] = $entries;
+        return $entries;
+    }
+}
@@ -0,0 +1,114 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * A prefix trie over option labels
+ *
+ * The labels are kept sorted, and each node of the trie records the range of
+ * labels which start with its prefix, so finding every label with a prefix
+ * costs the length of the prefix plus the number of labels found.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class LabelTrie
+{
+    private ImmVector<string> $labels;
+    private ImmVector<int> $ids;
+    private ImmVector<ImmMap<string,int>> $children;
+    private ImmVector<int> $starts;
+    private ImmVector<int> $ends;
+
+    /**
+     * Creates a new LabelTrie
+     *
+     * @param $labels - The option IDs keyed by label
+     */
+    public function __construct(KeyedTraversable<string,int> $labels)
+    {
+        $sorted = Map{};
+        foreach ($labels as $label => $id) {
+            $sorted[$label] = $id;
+        }
+        ksort($sorted, SORT_STRING);
+        $children = Vector{Map{}};
+        $starts = Vector{0};
+        $ends = Vector{0};
+        $i = 0;
+        foreach ($sorted as $label => $id) {
+            $node = 0;
+            $ends[0] = $i + 1;
+            $length = strlen($label);
+            for ($j = 0; $j < $length; $j++) {
+                $next = $children[$node]->get($label[$j]);
+                if ($next === null) {
+                    $next = $children->count();
+                    $children[$node][$label[$j]] = $next;
+                    $children[] = Map{};
+                    $starts[] = $i;
+                    $ends[] = $i;
+                }
+                $ends[$next] = $i + 1;
+                $node = $next;
+            }
+            $i++;
+        }
+        $this->labels = $sorted->keys()->immutable();
+        $this->ids = $sorted->values()->immutable();
+        $this->children = $children->map($c ==> $c->immutable())->immutable();
+        $this->starts = $starts->immutable();
+        $this->ends = $ends->immutable();
+    }
+
+    /**
+     * Finds every label that starts with a prefix.
+     *
+     * @param $prefix - The prefix
+     * @return - The option IDs keyed by label, in label order
+     */
+    public function find(string $prefix): ImmMap<string,int>
+    {
+        $node = $this->walk($prefix);
+        $found = Map{};
+        if ($node !== null) {
+            for ($i = $this->starts[$node]; $i < $this->ends[$node]; $i++) {
+                $found[$this->labels[$i]] = $this->ids[$i];
+            }
+        }
+        return $found->immutable();
+    }
+
+    /**
+     * Counts the labels that start with a prefix.
+     *
+     * @param $prefix - The prefix
+     * @return - The number of labels
+     */
+    public function count(string $prefix): int
+    {
+        $node = $this->walk($prefix);
+        return $node === null ? 0 : $this->ends[$node] - $this->starts[$node];
+    }
+
+    /**
+     * Finds the node for a prefix.
+     *
+     * @param $prefix - The prefix
+     * @return - The node index, or null if no label starts with the prefix
+     */
+    private function walk(string $prefix): ?int
+    {
+        $node = 0;
+        $length = strlen($prefix);
+        for ($j = 0; $j < $length && $node !== null; $j++) {
+            $node = $this->children[$node]->get($prefix[$j]);
+        }
+        return $node;
+    }
+}
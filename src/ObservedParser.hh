@@ -0,0 +1,216 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * A parser which reports its timings to an observer
+ *
+ * The timing lives in this subclass so a plain `Parser` doesn't pay for it.
+ * Label lookups and value conversions are timed on their own and left out of
+ * the tokenize phase. Each option value is reported once as converted, with
+ * the time spent converting it, wherever that happened, and storing it under
+ * every label used. Values converted later (e.g. with `Parser::LAZY`) aren't
+ * timed.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ObservedParser extends Parser
+{
+    /**
+     * The time spent on the current option event so far, not yet reported
+     */
+    private float $pending = 0.0;
+
+    /**
+     * The total time spent in lookups and conversions, to leave out of tokenizing
+     */
+    private float $excluded = 0.0;
+
+    /**
+     * Creates a new ObservedParser
+     *
+     * @param $observer - Receives the timings
+     * @param $options - The options to parse
+     * @param $mode - Any of the mode constants (e.g. `Parser::LAZY`)
+     * @param $commands - The root of a tree of subcommands whose scope is `$options`, if any
+     */
+    public function __construct(private ParseObserver $observer, OptionSet $options, int $mode = 0, ?CommandNode $commands = null)
+    {
+        parent::__construct($options, $mode, $commands);
+    }
+
+    /**
+     * Gets the observer.
+     *
+     * @return - The observer
+     */
+    public function getObserver(): ParseObserver
+    {
+        return $this->observer;
+    }
+
+    /**
+     * Parses a list of arguments into slots, timing the whole parse
+     *
+     * @param $arguments - The arguments
+     * @param $diagnostics - Collects errors instead of throwing them, if given
+     * @return - A parsed command
+     */
+    protected function collect(Traversable<string> $arguments, ?Vector<Diagnostic> $diagnostics = null): Command
+    {
+        $start = (float)microtime(true);
+        try {
+            return parent::collect($arguments, $diagnostics);
+        } finally {
+            $this->observer->onPhase(ParseObserver::PARSE, (float)microtime(true) - $start);
+        }
+    }
+
+    /**
+     * Reads arguments into events, timing only the reading
+     *
+     * @param $arguments - The arguments
+     * @param $tolerant - Whether to produce error events instead of throwing
+     * @return - The parse events
+     */
+    protected function scan(Traversable<string> $arguments, bool $tolerant): Generator<int,Event,void>
+    {
+        $elapsed = 0.0;
+        $start = (float)microtime(true);
+        $excluded = $this->excluded;
+        try {
+            foreach (parent::scan($arguments, $tolerant) as $event) {
+                $elapsed += (float)microtime(true) - $start - ($this->excluded - $excluded);
+                yield $event;
+                $this->flush();
+                $start = (float)microtime(true);
+                $excluded = $this->excluded;
+            }
+            $elapsed += (float)microtime(true) - $start - ($this->excluded - $excluded);
+        } finally {
+            $this->flush();
+            $this->observer->onPhase(ParseObserver::TOKENIZE, $elapsed);
+        }
+    }
+
+    /**
+     * Finds the ID of an option by label, timing the lookup
+     *
+     * @param $options - The options in scope
+     * @param $label - The label, without dashes
+     * @param $long - Whether the label was given with two dashes
+     * @return - The option ID, or null if no option has the label
+     */
+    protected function lookup(OptionSet $options, string $label, bool $long): ?int
+    {
+        $start = (float)microtime(true);
+        $id = parent::lookup($options, $label, $long);
+        $this->onLookup((float)microtime(true) - $start);
+        return $id;
+    }
+
+    /**
+     * Finds the long labels an abbreviated label could stand for, timing the lookup
+     *
+     * @param $options - The options in scope
+     * @param $label - The label, without dashes
+     * @return - The candidate labels
+     */
+    protected function lookupCandidates(OptionSet $options, string $label): ImmVector<string>
+    {
+        $start = (float)microtime(true);
+        $candidates = parent::lookupCandidates($options, $label);
+        $this->onLookup((float)microtime(true) - $start);
+        return $candidates;
+    }
+
+    /**
+     * Converts the value of an option event, timing the conversion
+     *
+     * @param $event - The option event
+     * @return - The converted value
+     * @throws \UnexpectedValueException if the value is invalid
+     */
+    protected function convert(Event $event): mixed
+    {
+        $start = (float)microtime(true);
+        try {
+            return parent::convert($event);
+        } finally {
+            $elapsed = (float)microtime(true) - $start;
+            $this->pending += $elapsed;
+            $this->excluded += $elapsed;
+        }
+    }
+
+    /**
+     * Stores an option value under the label typed, timing it with the option's value
+     *
+     * @param $event - The option event
+     * @param $first - The first label used for the option
+     * @param $values - The value of each slot, by option ID
+     * @param $aliases - The values by label of options used with more than one label
+     * @param $aliasOrder - The number of slots used when each label was first used, and the label
+     * @param $position - The number of slots used so far
+     * @param $raw - Whether to store the unconverted value
+     */
+    protected function addAlias(Event $event, string $first, Vector<mixed> $values, Map<string,mixed> $aliases, Vector<Pair<int,string>> $aliasOrder, int $position, bool $raw): void
+    {
+        $pending = $this->pending;
+        $start = (float)microtime(true);
+        parent::addAlias($event, $first, $values, $aliases, $aliasOrder, $position, $raw);
+        // the whole call replaces any conversion timed inside it
+        $this->pending = $pending + (float)microtime(true) - $start;
+    }
+
+    /**
+     * Adds an option value, timing its conversion
+     *
+     * @param $event - The option event
+     * @param $values - The value of each slot, by option ID
+     * @param $labels - The first label used for each slot
+     * @param $order - The IDs of the used slots, in the order first used
+     * @param $raw - Whether to store the unconverted value
+     */
+    protected function addOption(Event $event, Vector<mixed> $values, Vector<string> $labels, Vector<int> $order, bool $raw = false): void
+    {
+        $pending = $this->pending;
+        $start = (float)microtime(true);
+        parent::addOption($event, $values, $labels, $order, $raw);
+        $elapsed = $pending + (float)microtime(true) - $start;
+        $this->pending = 0.0;
+        $option = $event->getOption();
+        if ($option !== null) {
+            $this->observer->onOption((int)$event->getOptionId(), $option, $elapsed);
+        }
+        $this->observer->onPhase(ParseObserver::CONVERT, $elapsed);
+    }
+
+    /**
+     * Reports a label lookup, and leaves it out of tokenizing.
+     *
+     * @param $seconds - The time spent
+     */
+    private function onLookup(float $seconds): void
+    {
+        $this->excluded += $seconds;
+        $this->observer->onPhase(ParseObserver::LOOKUP, $seconds);
+    }
+
+    /**
+     * Reports conversion time left by an event that was never stored (e.g. an invalid value).
+     */
+    private function flush(): void
+    {
+        if ($this->pending > 0.0) {
+            $this->observer->onPhase(ParseObserver::CONVERT, $this->pending);
+            $this->pending = 0.0;
+        }
+    }
+}
@@ -15,54 +15,110 @@ namespace Cleopatra;
  */
 class Option
 {
-    private ImmSet<string> $shorts;
-    private ImmSet<string> $longs;
+    /**
+     * The option requires a value
+     */
+    const int REQUIRED = 1;
+    /**
+     * The option can take a value
+     */
+    const int OPTIONAL = 2;
+    /**
+     * The option is incremental
+     */
+    const int INCREMENTAL = 4;
+    /**
+     * The option can be used multiple times
+     */
+    const int MULTIPLE = 8;
+    /**
+     * The bits of the flag word which hold the type
+     */
+    const int TYPE_MASK = 48;
+    /**
+     * The value is a string
+     */
+    const int TYPE_STRING = 0;
+    /**
+     * The value is an integer
+     */
+    const int TYPE_INTEGER = 16;
+    /**
+     * The value is a float
+     */
+    const int TYPE_FLOAT = 32;
+    /**
+     * The value is a `DateTimeImmutable`
+     */
+    const int TYPE_DATE = 48;
+
+    private OptionSpec $spec;
     private string $description;
-    private bool $vector;
-    private bool $incremental = false;
-    private string $type = 's';
-    private ?bool $required;
+    private int $flags;
+    private int $limit = 0;
+    private bool $unique = false;
+    private bool $interned = false;
+    private (function(mixed): mixed) $converter;
 
     /**
      * Creates a new Option
      *
+     * Options with the same spec share one `OptionSpec`; see
+     * `OptionSpec::compile`.
+     *
      * @param $spec - The option specification
      * @param $description - A human readable description
+     * @throws \InvalidArgumentException if any labels are invalid, or the type isn't registered
      */
     public function __construct(string $spec, string $description)
     {
-        $this->vector = substr($spec, -1, 1) === '@';
-        $aspec = trim($spec, '@');
-        $matches = [];
-        if (preg_match('/:{1,2}([sifd])$/', $aspec, $matches)) {
-            $this->type = $matches[1];
-            $aspec = substr($aspec, 0, -1);
-        }
-        if (substr($aspec, -1, 1) === '+') {
-            $this->incremental = true;
-            $this->type = 'i';
-            $aspec = substr($aspec, 0, -1);
-        } elseif (substr($aspec, -2, 2) === '::') {
-            $aspec = substr($aspec, 0, -2);
-            $this->required = false;
-        } elseif (substr($aspec, -1, 1) === ':') {
-            $aspec = substr($aspec, 0, -1);
-            $this->required = true;
-        }
-        $shorts = Set{};
-        $longs = Set{};
-        foreach (explode("|", $aspec) as $v) {
-            if (!preg_match('/^[a-zA-Z0-9][a-zA-Z0-9\-]*$/', $v)) {
-                throw new \InvalidArgumentException('Option labels must only contain letters, numbers, and the dash');
-            } elseif (strlen($v) == 1) {
-                $shorts[] = $v;
-            } else {
-                $longs[] = $v;
-            }
-        }
-        $this->shorts = $shorts->immutable();
-        $this->longs = $longs->immutable();
+        $this->spec = OptionSpec::compile($spec);
+        $this->flags = $this->spec->getFlags();
         $this->description = trim($description);
+        $this->converter = $this->findConverter();
+    }
+
+    /**
+     * Gets the properties to serialize, leaving out the converter.
+     *
+     * @return - The property names
+     */
+    public function __sleep(): array<string>
+    {
+        return ['spec', 'description', 'flags', 'limit', 'unique', 'interned'];
+    }
+
+    /**
+     * Looks up the converter again after unserializing.
+     *
+     * @throws \InvalidArgumentException if the type isn't registered
+     */
+    public function __wakeup(): void
+    {
+        $this->converter = $this->findConverter();
+    }
+
+    /**
+     * Gets the compiled option specification.
+     *
+     * @return - The compiled spec
+     */
+    public function getSpec(): OptionSpec
+    {
+        return $this->spec;
+    }
+
+    /**
+     * Gets the packed flag word.
+     *
+     * The word is a combination of the `REQUIRED`, `OPTIONAL`, `INCREMENTAL`,
+     * and `MULTIPLE` bits, plus one of the `TYPE_*` values.
+     *
+     * @return - The flags
+     */
+    public function getFlags(): int
+    {
+        return $this->flags;
     }
 
     /**
@@ -75,6 +131,16 @@ class Option
         return $this->description;
     }
 
+    /**
+     * Gets the option name, the first label in the spec.
+     *
+     * @return - The name (e.g. `v` for `v|verbose+`)
+     */
+    public function getName(): string
+    {
+        return $this->spec->getName();
+    }
+
     /**
      * Gets the option long aliases
      *
@@ -82,7 +148,7 @@ class Option
      */
     public function getLongs(): ImmSet<string>
     {
-        return $this->longs;
+        return $this->spec->getLongs();
     }
 
     /**
@@ -92,17 +158,17 @@ class Option
      */
     public function getShorts(): ImmSet<string>
     {
-        return $this->shorts;
+        return $this->spec->getShorts();
     }
 
     /**
      * Gets the option type.
      *
-     * @return - The type: s, i, f, d
+     * @return - The type: s, i, f, d, or the name of a type in the `ConverterRegistry`
      */
     public function getType() : string
     {
-        return $this->type;
+        return $this->spec->getType();
     }
 
     /**
@@ -112,7 +178,7 @@ class Option
      */
     public function isIncremental(): bool
     {
-        return $this->incremental;
+        return ($this->flags & self::INCREMENTAL) !== 0;
     }
 
     /**
@@ -122,7 +188,7 @@ class Option
      */
     public function isRequired(): bool
     {
-        return $this->required === true;
+        return ($this->flags & self::REQUIRED) !== 0;
     }
 
     /**
@@ -132,7 +198,7 @@ class Option
      */
     public function isOptional(): bool
     {
-        return $this->required === false;
+        return ($this->flags & self::OPTIONAL) !== 0;
     }
 
     /**
@@ -142,7 +208,7 @@ class Option
      */
     public function isSolo(): bool
     {
-        return $this->required === null;
+        return ($this->flags & (self::REQUIRED | self::OPTIONAL)) === 0;
     }
 
     /**
@@ -152,7 +218,75 @@ class Option
      */
     public function isMultiple(): bool
     {
-        return $this->vector;
+        return ($this->flags & self::MULTIPLE) !== 0;
+    }
+
+    /**
+     * Sets the maximum number of values kept for a multiple option.
+     *
+     * Values past the limit are ignored.
+     *
+     * @param $limit - The maximum number of values, or zero for no limit
+     * @return - This option
+     */
+    public function setLimit(int $limit): this
+    {
+        $this->limit = max(0, $limit);
+        return $this;
+    }
+
+    /**
+     * Gets the maximum number of values kept for a multiple option.
+     *
+     * @return - The maximum number of values, or zero for no limit
+     */
+    public function getLimit(): int
+    {
+        return $this->limit;
+    }
+
+    /**
+     * Sets whether a multiple option ignores values it already has.
+     *
+     * @param $unique - Whether to ignore repeated values
+     * @return - This option
+     */
+    public function setUnique(bool $unique = true): this
+    {
+        $this->unique = $unique;
+        return $this;
+    }
+
+    /**
+     * Whether a multiple option ignores values it already has
+     *
+     * @return - true if repeated values are ignored
+     */
+    public function isUnique(): bool
+    {
+        return $this->unique;
+    }
+
+    /**
+     * Sets whether a multiple option shares one copy of equal string values.
+     *
+     * @param $interned - Whether to share equal strings
+     * @return - This option
+     */
+    public function setInterned(bool $interned = true): this
+    {
+        $this->interned = $interned;
+        return $this;
+    }
+
+    /**
+     * Whether a multiple option shares one copy of equal string values
+     *
+     * @return - true if equal strings are shared
+     */
+    public function isInterned(): bool
+    {
+        return $this->interned;
     }
 
     /**
@@ -160,17 +294,23 @@ class Option
      *
      * @param $value - The incoming value
      * @return - The converted value
+     * @throws \UnexpectedValueException if the value can't be converted
      */
     public function parse(mixed $value): mixed
     {
-        switch ($this->type) {
-            case "f":
-                return (float)$value;
-            case "i":
-                return (int)$value;
-            case "d":
-                return new \DateTimeImmutable($value);
-        }
-        return $this->required === null ? true : (string)$value;
+        $converter = $this->converter;
+        return $converter($value);
+    }
+
+    /**
+     * Finds the converter of the option type.
+     *
+     * @return - The converter
+     * @throws \InvalidArgumentException if the type isn't registered
+     */
+    private function findConverter(): (function(mixed): mixed)
+    {
+        return $this->isSolo() && !$this->isIncremental() ?
+            $value ==> true : ConverterRegistry::get($this->spec->getType());
     }
 }
@@ -10,13 +10,38 @@ namespace Cleopatra;
 /**
  * A set of options.
  *
+ * A combined set is a layer on top of the set it was combined from: only the
+ * new options are indexed, and they're checked for collisions by walking the
+ * layer label maps down to the nearest set whose merged map is already
+ * built. The merged lookup tables are only built for a set that's looked up
+ * by label, the first time they're needed.
+ *
+ * Constraints about which options can be used together are checked by the
+ * `Parser` once the arguments are read. A combined set keeps the constraints
+ * of both sets, so declare them before combining.
+ *
  * @copyright 2016 Appertly contributors
  * @license   MIT
  */
 class OptionSet
 {
-    private ImmMap<string,Option> $optionsByLabel;
-    private ImmVector<Option> $options;
+    /**
+     * The number of entries in the short label table
+     */
+    const int SHORT_TABLE_SIZE = 128;
+
+    private ?OptionSet $parent;
+    private int $offset = 0;
+    private ImmVector<Option> $layer;
+    private ImmVector<?int> $shortIds;
+    private ImmMap<string,int> $layerLongIds;
+    private ?ImmVector<Option> $options;
+    private ?ImmVector<int> $flags;
+    private ?ImmMap<string,int> $longIds;
+    private ?HelpLayout $help;
+    private ?LabelTrie $trie;
+    private Vector<Constraint> $constraints;
+    private ?ConstraintChecker $checker;
 
     /**
      * Creates a new OptionSet.
@@ -29,23 +54,21 @@ class OptionSet
         if (count($options) === 0) {
             throw new \InvalidArgumentException("You must provide at least one option");
         }
-        $byLabel = Map{};
-        foreach ($options as $option) {
-            foreach ($option->getShorts() as $o) {
-                if ($byLabel->containsKey($o)) {
-                    throw new \InvalidArgumentException("Duplicate option: -$o");
-                }
-                $byLabel[$o] = $option;
-            }
-            foreach ($option->getLongs() as $o) {
-                if ($byLabel->contains($o)) {
-                    throw new \InvalidArgumentException("Duplicate option: --$o");
-                }
-                $byLabel[$o] = $option;
-            }
-        }
-        $this->options = new ImmVector($options);
-        $this->optionsByLabel = $byLabel->immutable();
+        $this->layer = new ImmVector($options);
+        $this->constraints = Vector{};
+        list($shortIds, $longIds) = self::index($this->layer, 0, null);
+        $this->shortIds = $shortIds;
+        $this->layerLongIds = $longIds;
+    }
+
+    /**
+     * Gets the number of options.
+     *
+     * @return - The number of options
+     */
+    public function count(): int
+    {
+        return $this->offset + $this->layer->count();
     }
 
     /**
@@ -56,22 +79,245 @@ class OptionSet
      */
     public function getOption(string $label): ?Option
     {
-        return $this->optionsByLabel->get($label);
+        $id = $this->getLongId($label);
+        return $id === null ? null : $this->getOptions()[$id];
+    }
+
+    /**
+     * Gets the ID of the option with a short label.
+     *
+     * @param $ord - The byte value of the label character (e.g. `ord('v')`)
+     * @return - The option ID or null
+     */
+    public function getShortId(int $ord): ?int
+    {
+        return $this->shortIds->get($ord);
+    }
+
+    /**
+     * Gets the ID of the option with a label.
+     *
+     * Single-character labels are looked up in the short table, so `--v` will
+     * still resolve to the option labeled `v`.
+     *
+     * @param $label - The label
+     * @return - The option ID or null
+     */
+    public function getLongId(string $label): ?int
+    {
+        if (strlen($label) === 1) {
+            return $this->shortIds->get(ord($label));
+        }
+        return $this->getLongIds()->get($label);
+    }
+
+    /**
+     * Expands an abbreviated long label.
+     *
+     * A label is left alone if it's an exact label or no label starts with it.
+     * Otherwise it must be a prefix of the labels of only one option (e.g.
+     * `verb` for `verbose`); the first of those labels is returned.
+     *
+     * @param $label - The label or its prefix
+     * @return - The full label
+     * @throws \UnexpectedValueException if the prefix belongs to more than one option
+     */
+    public function expandLongLabel(string $label): string
+    {
+        $candidates = $this->getLongCandidates($label);
+        if ($candidates->count() > 1) {
+            throw new \UnexpectedValueException("Ambiguous option: --$label could be " . implode(', ', $candidates->map($l ==> "--$l")));
+        }
+        return $candidates->isEmpty() ? $label : $candidates[0];
+    }
+
+    /**
+     * Gets the long labels an abbreviated label could stand for.
+     *
+     * @param $label - The label or its prefix
+     * @return - The label if it's exact, the first label of the only option it prefixes, every label it prefixes if there are several options, or nothing
+     */
+    public function getLongCandidates(string $label): ImmVector<string>
+    {
+        if ($label === '') {
+            // an empty label is a prefix of every label, but never stands for one
+            return ImmVector{};
+        } elseif ($this->getLongId($label) !== null) {
+            return ImmVector{$label};
+        }
+        $trie = $this->getLabelTrie();
+        $count = $trie->count($label);
+        if ($count === 0) {
+            return ImmVector{};
+        }
+        $found = $trie->find($label);
+        if ($count > 1 && (new Set($found->values()))->count() > 1) {
+            return $found->keys();
+        }
+        return ImmVector{(string)$found->firstKey()};
+    }
+
+    /**
+     * Gets a prefix trie over the long labels, creating it if necessary.
+     *
+     * @return - The trie
+     */
+    public function getLabelTrie(): LabelTrie
+    {
+        $trie = $this->trie;
+        if ($trie === null) {
+            $trie = new LabelTrie($this->getLongIds());
+            $this->trie = $trie;
+        }
+        return $trie;
+    }
+
+    /**
+     * Gets an Option by ID.
+     *
+     * @param $id - The option ID
+     * @return - The option
+     */
+    public function getOptionById(int $id): Option
+    {
+        return $this->getOptions()[$id];
+    }
+
+    /**
+     * Gets the packed flag word of an option by ID.
+     *
+     * @param $id - The option ID
+     * @return - The flags (see `Option::getFlags`)
+     */
+    public function getFlags(int $id): int
+    {
+        $flags = $this->flags;
+        if ($flags === null) {
+            $flags = $this->getOptions()->map($o ==> $o->getFlags());
+            $this->flags = $flags;
+        }
+        return $flags[$id];
     }
 
     /**
      * Gets the options.
      *
+     * The options of a combined set are those of the original set followed
+     * by those of the other, so an option has the same ID in both.
+     *
      * @return - The options
      */
     public function getOptions(): ImmVector<Option>
     {
-        return $this->options;
+        $options = $this->options;
+        if ($options === null) {
+            $layers = Vector{};
+            $set = $this;
+            while ($set !== null) {
+                $merged = $set->options;
+                if ($merged !== null) {
+                    $layers[] = $merged;
+                    break;
+                }
+                $layers[] = $set->layer;
+                $set = $set->parent;
+            }
+            $all = Vector{};
+            for ($i = $layers->count() - 1; $i >= 0; $i--) {
+                $all->addAll($layers[$i]);
+            }
+            $options = $all->immutable();
+            $this->options = $options;
+        }
+        return $options;
+    }
+
+    /**
+     * Builds the merged lookup tables now instead of on first use.
+     *
+     * @return - This set
+     */
+    public function prepare(): this
+    {
+        $this->getOptions();
+        $this->getLongIds();
+        if ($this->flags === null) {
+            $this->getFlags(0);
+        }
+        return $this;
+    }
+
+    /**
+     * Declares that at most one of some options can be used.
+     *
+     * @param $labels - Any label of each option (e.g. `quiet`, `verbose`)
+     * @return - This set
+     * @throws \InvalidArgumentException if no option has a label, or there are fewer than two
+     */
+    public function exclusive(string ...$labels): this
+    {
+        if (count($labels) < 2) {
+            throw new \InvalidArgumentException("Exclusive options need at least two labels");
+        }
+        return $this->addConstraint(new Constraint(Constraint::EXCLUSIVE, $this->getIds($labels)));
+    }
+
+    /**
+     * Declares that using an option requires using others.
+     *
+     * @param $label - Any label of the option
+     * @param $required - Any label of each option it requires
+     * @return - This set
+     * @throws \InvalidArgumentException if no option has a label, or nothing is required
+     */
+    public function requires(string $label, string ...$required): this
+    {
+        if (count($required) === 0) {
+            throw new \InvalidArgumentException("Option $label must require at least one option");
+        }
+        $subject = $this->getIds([$label])[0];
+        return $this->addConstraint(new Constraint(Constraint::REQUIRES, $this->getIds($required), $subject));
+    }
+
+    /**
+     * Declares that at least one of some options must be used.
+     *
+     * @param $labels - Any label of each option
+     * @return - This set
+     * @throws \InvalidArgumentException if no option has a label, or there are none
+     */
+    public function atLeastOne(string ...$labels): this
+    {
+        if (count($labels) === 0) {
+            throw new \InvalidArgumentException("At least one label is required");
+        }
+        return $this->addConstraint(new Constraint(Constraint::AT_LEAST_ONE, $this->getIds($labels)));
+    }
+
+    /**
+     * Gets the compiled constraints, compiling them if necessary.
+     *
+     * @return - The constraints of this set, including those the sets it was combined from had then
+     */
+    public function getConstraints(): ConstraintChecker
+    {
+        $checker = $this->checker;
+        if ($checker === null) {
+            $checker = new ConstraintChecker($this, $this->constraints->immutable());
+            $this->checker = $checker;
+        }
+        return $checker;
     }
 
     /**
      * Combines this OptionSet with another.
      *
+     * Only the options of the other set are indexed, once, and checked
+     * against the label maps of this set's layers; this set is referenced,
+     * and its merged tables are neither built nor copied.
+     * The constraints of both sets are copied, so constraints declared on
+     * either one afterward don't apply to the combined set.
+     *
      * @param $other - The other options
      * @return - The new combined option set
      * @throws \InvalidArgumentException if any option labels collide
@@ -81,36 +327,212 @@ class OptionSet
         if ($this === $other) {
             return $this;
         }
-        $options = new Vector($this->options);
-        $options->addAll($other->options);
-        return new OptionSet(...$options);
+        $offset = $this->count();
+        $layer = $other->getOptions();
+        list($shortIds, $longIds) = self::index($layer, $offset, $this);
+        // a clone skips the constructor, which would index the layer again
+        $combined = clone $this;
+        $combined->parent = $this;
+        $combined->offset = $offset;
+        $combined->layer = $layer;
+        $combined->shortIds = $shortIds;
+        $combined->layerLongIds = $longIds;
+        $combined->options = null;
+        $combined->flags = null;
+        $combined->longIds = null;
+        $combined->help = null;
+        $combined->trie = null;
+        $combined->constraints = new Vector($this->constraints);
+        $combined->constraints->addAll($other->getConstraints()->getConstraints()->map($c ==> $c->withOffset($offset)));
+        $combined->checker = null;
+        return $combined;
+    }
+
+    /**
+     * Merges every layer of this set into one.
+     *
+     * The merged tables are built if necessary and shared with the copy,
+     * which doesn't reference the sets this one was combined from.
+     *
+     * @return - This set if it has only one layer, otherwise a copy with one
+     */
+    public function flatten(): OptionSet
+    {
+        if ($this->parent === null) {
+            return $this;
+        }
+        $this->prepare();
+        $flat = clone $this;
+        $flat->parent = null;
+        $flat->offset = 0;
+        $flat->layer = $this->getOptions();
+        $flat->layerLongIds = $this->getLongIds();
+        $flat->constraints = new Vector($this->constraints);
+        // the help layout and constraint checker refer to the set they were built for
+        $flat->help = null;
+        $flat->checker = null;
+        return $flat;
+    }
+
+    /**
+     * Adds a constraint to this set.
+     *
+     * @param $constraint - The constraint
+     * @return - This set
+     */
+    private function addConstraint(Constraint $constraint): this
+    {
+        $this->constraints[] = $constraint;
+        $this->checker = null;
+        return $this;
+    }
+
+    /**
+     * Gets the IDs of options by label.
+     *
+     * @param $labels - Any label of each option
+     * @return - The option IDs
+     * @throws \InvalidArgumentException if no option has a label
+     */
+    private function getIds(Traversable<string> $labels): ImmVector<int>
+    {
+        $ids = Vector{};
+        foreach ($labels as $label) {
+            $id = $this->getLongId($label);
+            if ($id === null) {
+                throw new \InvalidArgumentException("Unknown option: $label");
+            }
+            $ids[] = $id;
+        }
+        return $ids->immutable();
+    }
+
+    /**
+     * Indexes the labels of a layer of options.
+     *
+     * @param $layer - The options
+     * @param $offset - The ID of the first option
+     * @param $parent - The set the layer is added to, if any
+     * @return - The short label table and the long label map
+     * @throws \InvalidArgumentException if any option labels collide
+     */
+    private static function index(ImmVector<Option> $layer, int $offset, ?OptionSet $parent): (ImmVector<?int>, ImmMap<string,int>)
+    {
+        if ($parent === null) {
+            $shortIds = Vector{};
+            $shortIds->resize(self::SHORT_TABLE_SIZE, null);
+        } else {
+            $shortIds = new Vector($parent->shortIds);
+        }
+        $longIds = Map{};
+        foreach ($layer as $i => $option) {
+            $id = $offset + $i;
+            foreach ($option->getShorts() as $o) {
+                $ord = ord($o);
+                if ($shortIds[$ord] !== null) {
+                    throw new \InvalidArgumentException("Duplicate option: -$o");
+                }
+                $shortIds[$ord] = $id;
+            }
+            foreach ($option->getLongs() as $o) {
+                if ($longIds->containsKey($o) || ($parent !== null && $parent->findLongId($o) !== null)) {
+                    throw new \InvalidArgumentException("Duplicate option: --$o");
+                }
+                $longIds[$o] = $id;
+            }
+        }
+        return tuple($shortIds->immutable(), $longIds->immutable());
+    }
+
+    /**
+     * Finds the ID of the option with a long label without merging the maps.
+     *
+     * @param $label - The long label
+     * @return - The option ID or null
+     */
+    private function findLongId(string $label): ?int
+    {
+        $set = $this;
+        while ($set !== null) {
+            $merged = $set->longIds;
+            if ($merged !== null) {
+                return $merged->get($label);
+            }
+            $id = $set->layerLongIds->get($label);
+            if ($id !== null) {
+                return $id;
+            }
+            $set = $set->parent;
+        }
+        return null;
+    }
+
+    /**
+     * Gets the merged long label map, merging it if necessary.
+     *
+     * @return - The option IDs keyed by long label
+     */
+    private function getLongIds(): ImmMap<string,int>
+    {
+        $longIds = $this->longIds;
+        if ($longIds === null) {
+            $longIds = $this->mergeLongIds();
+            $this->longIds = $longIds;
+        }
+        return $longIds;
+    }
+
+    /**
+     * Merges the long label maps of every layer.
+     *
+     * @return - The long label map
+     */
+    private function mergeLongIds(): ImmMap<string,int>
+    {
+        $layers = Vector{};
+        $set = $this;
+        while ($set !== null) {
+            $merged = $set->longIds;
+            if ($merged !== null) {
+                $layers[] = $merged;
+                break;
+            }
+            $layers[] = $set->layerLongIds;
+            $set = $set->parent;
+        }
+        if ($layers->count() === 1) {
+            return $layers[0];
+        }
+        $all = Map{};
+        for ($i = $layers->count() - 1; $i >= 0; $i--) {
+            $all->setAll($layers[$i]);
+        }
+        return $all->immutable();
+    }
+
+    /**
+     * Gets the help text layout, creating it if necessary.
+     *
+     * @return - The help layout
+     */
+    public function getHelpLayout(): HelpLayout
+    {
+        $help = $this->help;
+        if ($help === null) {
+            $help = new HelpLayout($this);
+            $this->help = $help;
+        }
+        return $help;
     }
 
     /**
      * Gets a formatted help string for the option set.
      *
+     * @param $width - The number of columns, or zero to detect it
      * @return - a formatted help string
      */
-    public function getHelp(): string
-    {
-        $opts = Map{};
-        $longest = 0;
-        foreach ($this->options as $option) {
-            $keys = Set{};
-            $keys->addAll($option->getShorts()->map($a ==> "-$a"));
-            $keys->addAll($option->getLongs()->map($a ==> "--$a"));
-            $key = '  ' . implode(" ", $keys) . '  ';
-            $opts[$key] = $option->getDescription();
-            $longest = max($longest, strlen($key));
-        }
-        $out = '';
-        foreach ($opts as $k => $v) {
-            $out .= str_pad($k, $longest) .
-                str_replace(PHP_EOL,
-                    str_pad(PHP_EOL, $longest + 1),
-                    wordwrap($v, 79 - $longest, PHP_EOL)
-                ) . PHP_EOL;
-        }
-        return $out;
+    public function getHelp(int $width = HelpLayout::DEFAULT_WIDTH): string
+    {
+        return $this->getHelpLayout()->toString($width);
     }
 }
@@ -0,0 +1,194 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Saves compiled option sets so a process can load them instead of building them
+ *
+ * A snapshot holds an option set with its lookup tables, label trie, help
+ * layout, and constraints already built, so loading it is one
+ * `unserialize` call, which only creates the classes an option set is made
+ * of. Its header has a format marker, a version chosen by the caller, and a
+ * hash of each option's spec and description. A snapshot is rebuilt if its
+ * version doesn't match, or if its hash doesn't match the specs the caller
+ * passes in, which are hashed as strings without creating any options. The
+ * hash doesn't cover value settings (e.g. `Option::setLimit`) or
+ * constraints, so change the version when they change.
+ *
+ * Value converters aren't saved; each option looks its type up in the
+ * `ConverterRegistry` when it's loaded, so register any custom types first.
+ * For a tree of subcommands, load each command's options in its
+ * `CommandNode` factory so only the commands used are loaded.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class OptionSetCache
+{
+    /**
+     * The first line of every snapshot
+     */
+    const string FORMAT = 'cleopatra-options-1';
+
+    /**
+     * The only classes a snapshot may contain
+     */
+    private static array<string> $classes = [
+        OptionSet::class,
+        Option::class,
+        OptionSpec::class,
+        HelpLayout::class,
+        LabelTrie::class,
+        ConstraintChecker::class,
+        Constraint::class,
+        Vector::class,
+        ImmVector::class,
+        Map::class,
+        ImmMap::class,
+        ImmSet::class,
+        Pair::class,
+    ];
+
+    /**
+     * Creates a snapshot of an option set.
+     *
+     * Combined sets are saved as one layer, without the sets they were
+     * combined from.
+     *
+     * @param $options - The options, which are prepared if they haven't been
+     * @param $version - Identifies the code which declares the options (e.g. a release number)
+     * @return - The snapshot
+     * @throws \InvalidArgumentException if the version has a line break
+     */
+    public static function export(OptionSet $options, string $version = ''): string
+    {
+        if (strpbrk($version, "\r\n") !== false) {
+            throw new \InvalidArgumentException("Snapshot version must be a single line");
+        }
+        $flat = $options->flatten()->prepare();
+        $flat->getLabelTrie();
+        $flat->getHelpLayout();
+        $flat->getConstraints();
+        return self::FORMAT . "\n" . $version . "\n" . self::hash($flat) . "\n" . serialize($flat);
+    }
+
+    /**
+     * Loads an option set from a snapshot.
+     *
+     * @param $snapshot - The snapshot
+     * @param $version - The version the snapshot must have
+     * @param $specs - The description of each option by spec, in order, if the snapshot must have them
+     * @return - The options
+     * @throws \UnexpectedValueException if the snapshot is invalid, has another version or other specs, or doesn't match its hash
+     * @throws \InvalidArgumentException if an option has a type that isn't registered
+     */
+    public static function import(string $snapshot, string $version = '', ?KeyedTraversable<string,string> $specs = null): OptionSet
+    {
+        $parts = explode("\n", $snapshot, 4);
+        if (count($parts) !== 4 || $parts[0] !== self::FORMAT) {
+            throw new \UnexpectedValueException("Invalid option set snapshot");
+        } elseif ($parts[1] !== $version) {
+            throw new \UnexpectedValueException("Option set snapshot has version {$parts[1]}, expected $version");
+        } elseif ($specs !== null && self::hashSpecs($specs) !== $parts[2]) {
+            throw new \UnexpectedValueException("Option set snapshot doesn't match the specs");
+        }
+        $options = @unserialize($parts[3], ['allowed_classes' => self::$classes]);
+        if (!($options instanceof OptionSet)) {
+            throw new \UnexpectedValueException("Invalid option set snapshot");
+        } elseif (self::hash($options) !== $parts[2]) {
+            throw new \UnexpectedValueException("Option set snapshot doesn't match its hash");
+        }
+        return $options;
+    }
+
+    /**
+     * Loads an option set from a file, building and saving it if necessary.
+     *
+     * The file is replaced atomically, so concurrent processes never read
+     * half of one. If it can't be written, the built options are still
+     * returned.
+     *
+     * @param $path - The path to the snapshot file
+     * @param $version - The version the snapshot must have
+     * @param $specs - The description of each option `$build` creates, by spec, in order
+     * @param $build - Creates the options if the file is missing, stale, or invalid
+     * @return - The options
+     */
+    public static function loadFile(string $path, string $version, KeyedTraversable<string,string> $specs, (function(): OptionSet) $build): OptionSet
+    {
+        $snapshot = @file_get_contents($path);
+        if (is_string($snapshot)) {
+            try {
+                return self::import($snapshot, $version, $specs);
+            } catch (\UnexpectedValueException $e) {
+                // rebuild it
+            }
+        }
+        $options = $build();
+        $temp = $path . '.' . getmypid() . '.tmp';
+        if (@file_put_contents($temp, self::export($options, $version)) === false || !@rename($temp, $path)) {
+            @unlink($temp);
+        }
+        return $options;
+    }
+
+    /**
+     * Loads an option set from APC, building and storing it if necessary.
+     *
+     * @param $key - The APC key
+     * @param $version - The version the snapshot must have
+     * @param $specs - The description of each option `$build` creates, by spec, in order
+     * @param $build - Creates the options if the entry is missing, stale, or invalid
+     * @param $ttl - The number of seconds to keep the entry, or zero to keep it until it's evicted
+     * @return - The options
+     */
+    public static function loadApc(string $key, string $version, KeyedTraversable<string,string> $specs, (function(): OptionSet) $build, int $ttl = 0): OptionSet
+    {
+        $snapshot = apc_fetch($key);
+        if (is_string($snapshot)) {
+            try {
+                return self::import($snapshot, $version, $specs);
+            } catch (\UnexpectedValueException $e) {
+                // rebuild it
+            }
+        }
+        $options = $build();
+        apc_store($key, self::export($options, $version), $ttl);
+        return $options;
+    }
+
+    /**
+     * Gets a hash of the specs of an option set.
+     *
+     * @param $options - The options
+     * @return - The SHA-1 hash, in hex, the same as `hashSpecs` gives for their specs
+     */
+    public static function hash(OptionSet $options): string
+    {
+        $specs = Map{};
+        foreach ($options->getOptions() as $option) {
+            $specs[$option->getSpec()->getSpec()] = $option->getDescription();
+        }
+        return self::hashSpecs($specs);
+    }
+
+    /**
+     * Gets a hash of option specs.
+     *
+     * @param $specs - The description of each option by spec, in order
+     * @return - The SHA-1 hash, in hex
+     */
+    public static function hashSpecs(KeyedTraversable<string,string> $specs): string
+    {
+        $context = hash_init('sha1');
+        foreach ($specs as $spec => $description) {
+            hash_update($context, $spec . "\0" . $description . "\n");
+        }
+        return hash_final($context);
+    }
+}
@@ -0,0 +1,226 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * A compiled option specification
+ *
+ * Specs are immutable, so `compile` hands out a shared instance for each spec
+ * string it has seen. The cache holds a limited number of specs; the oldest
+ * are dropped first.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class OptionSpec
+{
+    private static array<string,OptionSpec> $cache = [];
+    private static int $cacheLimit = 1024;
+    private static ?ParseObserver $observer;
+
+    private ImmSet<string> $shorts;
+    private ImmSet<string> $longs;
+    private string $name;
+    private int $flags;
+    private string $type = 's';
+
+    /**
+     * Creates a new OptionSpec
+     *
+     * @param $spec - The option specification
+     * @throws \InvalidArgumentException if any labels are invalid
+     */
+    public function __construct(private string $spec)
+    {
+        $flags = substr($spec, -1, 1) === '@' ? Option::MULTIPLE : 0;
+        $aspec = trim($spec, '@');
+        $matches = [];
+        if (preg_match('/:{1,2}([sifd]|[a-zA-Z][a-zA-Z0-9_\-]+)$/', $aspec, $matches)) {
+            $this->type = $matches[1];
+            $flags |= self::typeBits($matches[1]);
+            $aspec = substr($aspec, 0, -strlen($matches[1]));
+        }
+        if (substr($aspec, -1, 1) === '+') {
+            $this->type = 'i';
+            $flags = ($flags & ~Option::TYPE_MASK) | Option::INCREMENTAL | Option::TYPE_INTEGER;
+            $aspec = substr($aspec, 0, -1);
+        } elseif (substr($aspec, -2, 2) === '::') {
+            $aspec = substr($aspec, 0, -2);
+            $flags |= Option::OPTIONAL;
+        } elseif (substr($aspec, -1, 1) === ':') {
+            $aspec = substr($aspec, 0, -1);
+            $flags |= Option::REQUIRED;
+        }
+        $shorts = Set{};
+        $longs = Set{};
+        $name = '';
+        foreach (explode("|", $aspec) as $v) {
+            if (!preg_match('/^[a-zA-Z0-9][a-zA-Z0-9\-]*$/', $v)) {
+                throw new \InvalidArgumentException('Option labels must only contain letters, numbers, and the dash');
+            } elseif ($name === '') {
+                $name = $v;
+            }
+            if (strlen($v) == 1) {
+                $shorts[] = $v;
+            } else {
+                $longs[] = $v;
+            }
+        }
+        $this->shorts = $shorts->immutable();
+        $this->longs = $longs->immutable();
+        $this->name = $name;
+        $this->flags = $flags;
+    }
+
+    /**
+     * Gets the shared compiled spec for a spec string.
+     *
+     * @param $spec - The option specification
+     * @return - The compiled spec
+     * @throws \InvalidArgumentException if any labels are invalid
+     */
+    public static function compile(string $spec): OptionSpec
+    {
+        if (array_key_exists($spec, self::$cache)) {
+            return self::$cache[$spec];
+        }
+        $observer = self::$observer;
+        if ($observer === null) {
+            $compiled = new OptionSpec($spec);
+        } else {
+            $start = (float)microtime(true);
+            $compiled = new OptionSpec($spec);
+            $observer->onPhase(ParseObserver::COMPILE, (float)microtime(true) - $start);
+        }
+        if (count(self::$cache) >= self::$cacheLimit) {
+            foreach (self::$cache as $k => $v) {
+                unset(self::$cache[$k]);
+                break;
+            }
+        }
+        if (self::$cacheLimit > 0) {
+            self::$cache[$spec] = $compiled;
+        }
+        return $compiled;
+    }
+
+    /**
+     * Removes all compiled specs from the cache.
+     */
+    public static function clearCache(): void
+    {
+        self::$cache = [];
+    }
+
+    /**
+     * Sets the maximum number of compiled specs to cache.
+     *
+     * @param $limit - The maximum number of specs; zero disables the cache
+     */
+    public static function setCacheLimit(int $limit): void
+    {
+        self::$cacheLimit = max(0, $limit);
+        while (count(self::$cache) > self::$cacheLimit) {
+            foreach (self::$cache as $k => $v) {
+                unset(self::$cache[$k]);
+                break;
+            }
+        }
+    }
+
+    /**
+     * Sets the observer told how long each spec takes to compile.
+     *
+     * Specs found in the cache aren't reported.
+     *
+     * @param $observer - The observer, or null to stop observing
+     */
+    public static function setObserver(?ParseObserver $observer): void
+    {
+        self::$observer = $observer;
+    }
+
+    /**
+     * Gets the value type.
+     *
+     * @return - `s`, `i`, `f`, `d`, or the name of a type in the `ConverterRegistry`
+     */
+    public function getType(): string
+    {
+        return $this->type;
+    }
+
+    /**
+     * Gets the spec string.
+     *
+     * @return - The option specification
+     */
+    public function getSpec(): string
+    {
+        return $this->spec;
+    }
+
+    /**
+     * Gets the canonical name, the first label in the spec.
+     *
+     * @return - The name (e.g. `v` for `v|verbose+`)
+     */
+    public function getName(): string
+    {
+        return $this->name;
+    }
+
+    /**
+     * Gets the long aliases
+     *
+     * @return - The long aliases
+     */
+    public function getLongs(): ImmSet<string>
+    {
+        return $this->longs;
+    }
+
+    /**
+     * Gets the short aliases.
+     *
+     * @return - The short aliases
+     */
+    public function getShorts(): ImmSet<string>
+    {
+        return $this->shorts;
+    }
+
+    /**
+     * Gets the packed flag word (see `Option::getFlags`).
+     *
+     * @return - The flags
+     */
+    public function getFlags(): int
+    {
+        return $this->flags;
+    }
+
+    /**
+     * Gets the type bits for a type character.
+     *
+     * @param $type - The type: s, i, f, d
+     * @return - The type bits
+     */
+    private static function typeBits(string $type): int
+    {
+        switch ($type) {
+            case "i":
+                return Option::TYPE_INTEGER;
+            case "f":
+                return Option::TYPE_FLOAT;
+            case "d":
+                return Option::TYPE_DATE;
+        }
+        return Option::TYPE_STRING;
+    }
+}
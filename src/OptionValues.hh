@@ -0,0 +1,300 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Parsed option values stored by option ID
+ *
+ * Each option has one slot no matter which of its aliases was used, so
+ * `-v --verbose` counts twice and `-e a --exclude b` collects both values.
+ * Values can be looked up by any alias. If the values are unconverted, each
+ * slot is converted the first time it's read.
+ *
+ * `toMap` keeps the values of each label typed apart, the way `Command`
+ * always has; the parser only stores them separately for options used with
+ * more than one label.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class OptionValues
+{
+    private Vector<mixed> $values;
+    private Vector<bool> $unconverted;
+    private ?ImmMap<string,mixed> $map;
+
+    /**
+     * Creates a new OptionValues
+     *
+     * @param $options - The option set whose IDs are used
+     * @param $source - The value of each slot, by option ID
+     * @param $labels - The first label used for each slot, or an empty string if it wasn't used
+     * @param $order - The IDs of the used slots, in the order first used
+     * @param $raw - Whether the values are unconverted
+     * @param $aliases - The values by label typed of options used with more than one label, if any
+     * @param $aliasOrder - The number of slots used when each of those labels was first used, and the label
+     */
+    public function __construct(private OptionSet $options, private ImmVector<mixed> $source, private ImmVector<string> $labels, private ImmVector<int> $order, private bool $raw = false, private ?ImmMap<string,mixed> $aliases = null, private ?ImmVector<Pair<int,string>> $aliasOrder = null)
+    {
+        $this->values = new Vector($source);
+        $this->unconverted = Vector{};
+        $this->unconverted->resize($source->count(), false);
+        if ($raw) {
+            foreach ($order as $id) {
+                $this->unconverted[$id] = true;
+            }
+        }
+    }
+
+    /**
+     * Gets the option set whose IDs are used.
+     *
+     * @return - The option set
+     */
+    public function getOptionSet(): OptionSet
+    {
+        return $this->options;
+    }
+
+    /**
+     * Gets the ID of an option by any of its labels.
+     *
+     * @param $label - The label
+     * @return - The option ID, or null if no option has the label
+     */
+    public function getId(string $label): ?int
+    {
+        return $this->options->getLongId($label);
+    }
+
+    /**
+     * Gets the IDs of the options used, in the order first used.
+     *
+     * @return - The option IDs
+     */
+    public function getUsedIds(): ImmVector<int>
+    {
+        return $this->order;
+    }
+
+    /**
+     * Whether an option has a value.
+     *
+     * @param $id - The option ID
+     * @return - true if the option has a value
+     */
+    public function isUsed(int $id): bool
+    {
+        return (string)$this->labels->get($id) !== '';
+    }
+
+    /**
+     * Gets a copy with values added for options that don't have any.
+     *
+     * The values are converted when these values are. Each is keyed by the
+     * name of its option (see `Option::getName`) and ordered after the
+     * values already present.
+     *
+     * @param $values - The unconverted values by option ID
+     * @return - The new values
+     */
+    public function withFallbacks(KeyedTraversable<int,mixed> $values): OptionValues
+    {
+        $source = new Vector($this->source);
+        $labels = new Vector($this->labels);
+        $order = new Vector($this->order);
+        foreach ($values as $id => $value) {
+            if ($labels[$id] !== '') {
+                continue;
+            }
+            $option = $this->options->getOptionById($id);
+            if (!$this->raw) {
+                $value = $value instanceof Vector ?
+                    $value->map($v ==> $option->parse($v)) : $option->parse($value);
+            }
+            $source[$id] = $value;
+            $labels[$id] = $option->getName();
+            $order[] = $id;
+        }
+        return new OptionValues($this->options, $source->immutable(), $labels->immutable(), $order->immutable(), $this->raw, $this->aliases, $this->aliasOrder);
+    }
+
+    /**
+     * Whether an option was used.
+     *
+     * @param $label - Any label of the option
+     * @return - true if the option was used
+     */
+    public function has(string $label): bool
+    {
+        $id = $this->options->getLongId($label);
+        return $id !== null && $this->labels->get($id) !== '';
+    }
+
+    /**
+     * Gets the value of an option by any of its labels.
+     *
+     * @param $label - Any label of the option
+     * @return - The value, or null if the option wasn't used
+     */
+    public function get(string $label): mixed
+    {
+        $id = $this->options->getLongId($label);
+        return $id === null ? null : $this->getById($id);
+    }
+
+    /**
+     * Gets the value of an option by ID, converting it if necessary.
+     *
+     * @param $id - The option ID
+     * @return - The value, or null if the option wasn't used
+     */
+    public function getById(int $id): mixed
+    {
+        if (!$this->unconverted->get($id)) {
+            return $this->values->get($id);
+        }
+        $option = $this->options->getOptionById($id);
+        $raw = $this->source[$id];
+        $value = $raw instanceof Vector ?
+            $raw->map($v ==> $option->parse($v)) : $option->parse($raw);
+        $this->values[$id] = $value;
+        $this->unconverted[$id] = false;
+        return $value;
+    }
+
+    /**
+     * Gets the unconverted value of an option by ID.
+     *
+     * If the values were converted while parsing, they're returned as-is.
+     *
+     * @param $id - The option ID
+     * @return - The value, or null if the option wasn't used
+     */
+    public function getRawById(int $id): mixed
+    {
+        return $this->source->get($id);
+    }
+
+    /**
+     * Gets the values keyed by each label typed.
+     *
+     * This is the same shape as the map of options that `Command` has always
+     * returned: `-e a --exclude b` gives `e` and `exclude` a value each, and
+     * incremental options are counted per label. It's built the first time
+     * it's requested.
+     *
+     * @return - The values
+     */
+    public function toMap(): ImmMap<string,mixed>
+    {
+        $map = $this->map;
+        if ($map === null) {
+            $map = $this->toLabelMap(true);
+            $this->map = $map;
+        }
+        return $map;
+    }
+
+    /**
+     * Gets the unconverted values keyed by each label typed.
+     *
+     * @return - The unconverted values
+     */
+    public function toRawMap(): ImmMap<string,mixed>
+    {
+        return $this->toLabelMap(false);
+    }
+
+    /**
+     * Gets the values keyed by the first label used for each option.
+     *
+     * The values of all the labels of an option are merged, so
+     * `-e a --exclude b` gives `e` both values.
+     *
+     * @return - The values
+     */
+    public function toMergedMap(): ImmMap<string,mixed>
+    {
+        $values = Map{};
+        foreach ($this->order as $id) {
+            $values[$this->labels[$id]] = $this->getById($id);
+        }
+        return $values->immutable();
+    }
+
+    /**
+     * Gets the values keyed by option name (see `Option::getName`).
+     *
+     * @return - The values
+     */
+    public function toNamedMap(): ImmMap<string,mixed>
+    {
+        $values = Map{};
+        foreach ($this->order as $id) {
+            $values[$this->options->getOptionById($id)->getName()] = $this->getById($id);
+        }
+        return $values->immutable();
+    }
+
+    /**
+     * Builds the values keyed by each label typed, in the order first typed.
+     *
+     * @param $convert - Whether to convert the values
+     * @return - The values
+     */
+    private function toLabelMap(bool $convert): ImmMap<string,mixed>
+    {
+        $values = Map{};
+        $aliases = $this->aliases;
+        $aliasOrder = $this->aliasOrder;
+        if ($aliases === null || $aliasOrder === null) {
+            $aliases = ImmMap{};
+            $aliasOrder = ImmVector{};
+        }
+        $next = 0;
+        $count = $this->order->count();
+        for ($i = 0; $i <= $count; $i++) {
+            while ($next < $aliasOrder->count() && $aliasOrder[$next][0] <= $i) {
+                $label = $aliasOrder[$next][1];
+                $values[$label] = $this->getAlias($label, $convert);
+                $next++;
+            }
+            if ($i === $count) {
+                break;
+            }
+            $id = $this->order[$i];
+            $label = $this->labels[$id];
+            if ($aliases->containsKey($label)) {
+                $values[$label] = $this->getAlias($label, $convert);
+            } else {
+                $values[$label] = $convert ? $this->getById($id) : $this->getRawById($id);
+            }
+        }
+        return $values->immutable();
+    }
+
+    /**
+     * Gets the value stored under one label of an option used with more than one label.
+     *
+     * @param $label - The label typed
+     * @param $convert - Whether to convert the value
+     * @return - The value
+     */
+    private function getAlias(string $label, bool $convert): mixed
+    {
+        $aliases = $this->aliases;
+        $value = $aliases === null ? null : $aliases->get($label);
+        $option = $this->options->getOption($label);
+        if (!$convert || !$this->raw || $value === null || $option === null) {
+            return $value;
+        }
+        return $value instanceof Vector ?
+            $value->map($v ==> $option->parse($v)) : $option->parse($value);
+    }
+}
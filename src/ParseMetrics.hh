@@ -0,0 +1,91 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Counts and sums the timings of observed parsers
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ParseMetrics implements ParseObserver
+{
+    private Map<string,int> $phaseCounts;
+    private Map<string,float> $phaseSeconds;
+    private Map<string,int> $optionHits;
+    private Map<string,float> $optionSeconds;
+
+    /**
+     * Creates a new ParseMetrics
+     */
+    public function __construct()
+    {
+        $this->phaseCounts = Map{};
+        $this->phaseSeconds = Map{};
+        $this->optionHits = Map{};
+        $this->optionSeconds = Map{};
+    }
+
+    /**
+     * Called when a phase finishes.
+     *
+     * @param $phase - The phase (e.g. `ParseObserver::TOKENIZE`)
+     * @param $seconds - The time spent
+     */
+    public function onPhase(string $phase, float $seconds): void
+    {
+        $this->phaseCounts[$phase] = (int)$this->phaseCounts->get($phase) + 1;
+        $this->phaseSeconds[$phase] = (float)$this->phaseSeconds->get($phase) + $seconds;
+    }
+
+    /**
+     * Called when an option's value is stored in a command.
+     *
+     * @param $id - The option ID
+     * @param $option - The option
+     * @param $seconds - The time spent converting and storing the value
+     */
+    public function onOption(int $id, Option $option, float $seconds): void
+    {
+        $name = $option->getName();
+        $this->optionHits[$name] = (int)$this->optionHits->get($name) + 1;
+        $this->optionSeconds[$name] = (float)$this->optionSeconds->get($name) + $seconds;
+    }
+
+    /**
+     * Gets the metrics gathered so far.
+     *
+     * The snapshot has a `phases` map and an `options` map (keyed by option
+     * name), each entry having a `count` and the total `seconds`.
+     *
+     * @return - The metrics
+     */
+    public function snapshot(): ImmMap<string,ImmMap<string,ImmMap<string,num>>>
+    {
+        $phases = Map{};
+        foreach ($this->phaseCounts as $phase => $count) {
+            $phases[$phase] = ImmMap{'count' => $count, 'seconds' => $this->phaseSeconds[$phase]};
+        }
+        $options = Map{};
+        foreach ($this->optionHits as $name => $count) {
+            $options[$name] = ImmMap{'count' => $count, 'seconds' => $this->optionSeconds[$name]};
+        }
+        return ImmMap{'phases' => $phases->immutable(), 'options' => $options->immutable()};
+    }
+
+    /**
+     * Forgets the metrics gathered so far.
+     */
+    public function reset(): void
+    {
+        $this->phaseCounts->clear();
+        $this->phaseSeconds->clear();
+        $this->optionHits->clear();
+        $this->optionSeconds->clear();
+    }
+}
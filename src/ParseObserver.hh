@@ -0,0 +1,61 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Receives timings from an observed parser
+ *
+ * See `Parser::observe` and `OptionSpec::setObserver`.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+interface ParseObserver
+{
+    /**
+     * Compiling an option spec that wasn't cached
+     */
+    const string COMPILE = 'compile';
+
+    /**
+     * Reading arguments into events, not including label lookups or value conversions
+     */
+    const string TOKENIZE = 'tokenize';
+
+    /**
+     * Finding an option by label, or the labels an abbreviation could stand for
+     */
+    const string LOOKUP = 'lookup';
+
+    /**
+     * Converting an option value and storing it under every label used
+     */
+    const string CONVERT = 'convert';
+
+    /**
+     * Parsing a whole command
+     */
+    const string PARSE = 'parse';
+
+    /**
+     * Called when a phase finishes.
+     *
+     * @param $phase - The phase (e.g. `ParseObserver::TOKENIZE`)
+     * @param $seconds - The time spent
+     */
+    public function onPhase(string $phase, float $seconds): void;
+
+    /**
+     * Called when an option's value is stored in a command.
+     *
+     * @param $id - The option ID
+     * @param $option - The option
+     * @param $seconds - The time spent converting and storing the value
+     */
+    public function onOption(int $id, Option $option, float $seconds): void;
+}
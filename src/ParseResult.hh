@@ -0,0 +1,60 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * The outcome of parsing without exceptions
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ParseResult
+{
+    /**
+     * Creates a new ParseResult
+     *
+     * @param $command - The command, with every argument that could be read
+     * @param $diagnostics - The errors, in argument order
+     */
+    public function __construct(private Command $command, private ImmVector<Diagnostic> $diagnostics)
+    {
+    }
+
+    /**
+     * Gets the command.
+     *
+     * If there were errors, the command has only the arguments and options
+     * which could be read.
+     *
+     * @return - The command
+     */
+    public function getCommand(): Command
+    {
+        return $this->command;
+    }
+
+    /**
+     * Gets the errors.
+     *
+     * @return - The errors, in argument order
+     */
+    public function getDiagnostics(): ImmVector<Diagnostic>
+    {
+        return $this->diagnostics;
+    }
+
+    /**
+     * Whether the arguments parsed without errors.
+     *
+     * @return - true if there are no errors
+     */
+    public function isValid(): bool
+    {
+        return $this->diagnostics->isEmpty();
+    }
+}
@@ -15,13 +15,63 @@ namespace Cleopatra;
  */
 class Parser
 {
+    /**
+     * Values are converted when they're first read from the `Command`
+     */
+    const int LAZY = 1;
+
+    /**
+     * Long labels can be abbreviated to any unique prefix (e.g. `--verb`)
+     */
+    const int ABBREVIATE = 2;
+
+    /**
+     * Constraints aren't checked while parsing; `FallbackResolver::resolve` checks them once fallbacks are filled in
+     */
+    const int DEFER_CONSTRAINTS = 4;
+
+    private ImmVector<mixed> $emptyValues = ImmVector{};
+    private ImmVector<string> $emptyLabels = ImmVector{};
+
     /**
      * Creates a new Parser
      *
      * @param $options - The options to parse
+     * @param $mode - Any of the mode constants (e.g. `Parser::LAZY`)
+     * @param $commands - The root of a tree of subcommands whose scope is `$options`, if any
+     */
+    public function __construct(protected OptionSet $options, protected int $mode = 0, protected ?CommandNode $commands = null)
+    {
+    }
+
+    /**
+     * Creates a new Parser for a tree of subcommands
+     *
+     * When a positional argument is the name of a subcommand of the current
+     * command, the parser descends into it and accepts its options from then
+     * on, along with those of all its ancestors. Once a positional argument
+     * isn't a subcommand, the parser stops descending.
+     *
+     * @param $root - The root command
+     * @param $mode - Any of the mode constants (e.g. `Parser::LAZY`)
+     * @return - The parser
+     */
+    public static function forCommands(CommandNode $root, int $mode = 0): Parser
+    {
+        return new Parser($root->getScope(), $mode, $root);
+    }
+
+    /**
+     * Creates a parser for the same options which reports its timings
+     *
+     * This parser is left as it is, so it doesn't pay for the timing.
+     *
+     * @param $observer - Receives the timings (e.g. a `ParseMetrics`)
+     * @return - The observed parser
      */
-    public function __construct(protected OptionSet $options)
+    public function observe(ParseObserver $observer): ObservedParser
     {
+        return new ObservedParser($observer, $this->options, $this->mode, $this->commands);
     }
 
     /**
@@ -30,132 +80,489 @@ class Parser
      * @param $arguments - The arguments
      * @return - A parsed command
      * @throws \InvalidArgumentException if the arguments parameter is empty
-     * @throws \UnexpectedValueException if an unknown option is used or a required value is not supplied
+     * @throws \UnexpectedValueException if an unknown or ambiguous option is used or a required value is not supplied
+     * @throws ConstraintException if the options used break any constraints of the option set
      */
     public function parse(Traversable<string> $arguments): Command
     {
-        if (count($arguments) === 0) {
-            throw new \InvalidArgumentException("Arguments parameter must not be empty");
+        return $this->collect($arguments);
+    }
+
+    /**
+     * Parses a list of arguments into slots
+     *
+     * Each command's slots are copied from empty ones built once per option
+     * count, then handed to its values as they are; they're never written
+     * again, so nothing is copied a second time.
+     *
+     * @param $arguments - The arguments
+     * @param $diagnostics - Collects errors instead of throwing them, if given
+     * @return - A parsed command
+     */
+    protected function collect(Traversable<string> $arguments, ?Vector<Diagnostic> $diagnostics = null): Command
+    {
+        $program = '';
+        $options = $this->options;
+        $node = $this->commands;
+        $count = $options->count();
+        if ($this->emptyValues->count() !== $count) {
+            $this->emptyValues = new ImmVector(array_fill(0, $count, null));
+            $this->emptyLabels = new ImmVector(array_fill(0, $count, ''));
         }
-        $args = new Vector($arguments);
-        $args->reverse();
-        $program = $args->pop();
-        $options = Map{};
-        $arguments = Vector{};
-        while (!$args->isEmpty()) {
-            $arg = $args->pop();
-            if ($arg == '--') {
-                $args->reverse();
-                $arguments->addAll($args);
-                $args->clear();
-            } elseif (substr($arg, 0, 2) === '--') {
-                $this->parseLong(substr($arg, 2), $args, $options);
-            } elseif (substr($arg, 0, 1) === '-') {
-                $this->parseShort(substr($arg, 1), $args, $options);
-            } else {
-                $arguments[] = $arg;
+        $values = new Vector($this->emptyValues);
+        $labels = new Vector($this->emptyLabels);
+        $order = Vector{};
+        $aliases = Map{};
+        $aliasOrder = Vector{};
+        $operands = Vector{};
+        $path = Vector{};
+        $lazy = ($this->mode & self::LAZY) !== 0;
+        foreach ($this->scan($arguments, $diagnostics !== null) as $event) {
+            switch ($event->getType()) {
+                case EventType::OPTION:
+                    $first = (string)$labels->get((int)$event->getOptionId());
+                    if ($first !== '' && ($first !== $event->getLabel() || $aliases->containsKey($first))) {
+                        $this->addAlias($event, $first, $values, $aliases, $aliasOrder, $order->count(), $lazy);
+                    }
+                    $this->addOption($event, $values, $labels, $order, $lazy);
+                    break;
+                case EventType::ARGUMENT:
+                    $operands[] = (string)$event->getValue();
+                    break;
+                case EventType::SUBCOMMAND:
+                    $name = (string)$event->getValue();
+                    $node = $node === null ? null : $node->getChild($name);
+                    if ($node !== null) {
+                        $options = $node->getScope();
+                        $path[] = $name;
+                    }
+                    break;
+                case EventType::PROGRAM:
+                    $program = (string)$event->getValue();
+                    break;
+                case EventType::ERROR:
+                    $diagnostic = $event->getValue();
+                    if ($diagnostics !== null && $diagnostic instanceof Diagnostic) {
+                        $diagnostics[] = $diagnostic;
+                    }
+                    break;
+                case EventType::END_OF_OPTIONS:
+                    break;
+            }
+        }
+        foreach ($order as $id) {
+            $slot = $values[$id];
+            if ($slot instanceof ValueList) {
+                $values[$id] = $slot->toVector();
             }
         }
-        return new Command($program, $options->immutable(), $arguments->immutable());
+        if (($this->mode & self::DEFER_CONSTRAINTS) === 0) {
+            $violations = $options->getConstraints()->check($order);
+            if (!$violations->isEmpty()) {
+                if ($diagnostics === null) {
+                    throw new ConstraintException($violations);
+                }
+                $diagnostics->addAll($violations);
+            }
+        }
+        $count = $options->count();
+        if ($values->count() < $count) {
+            $values->resize($count, null);
+            $labels->resize($count, '');
+        }
+        return Command::fromValues(
+            $program,
+            new OptionValues(
+                $options,
+                $values->immutable(),
+                $labels->immutable(),
+                $order->immutable(),
+                $lazy,
+                $aliases->map($a ==> $a instanceof ValueList ? $a->toVector() : $a)->immutable(),
+                $aliasOrder->immutable()
+            ),
+            $operands->immutable(),
+            $path->immutable()
+        );
     }
 
     /**
-     * Safely adds an option to the map, taking into account multiplicity.
+     * Parses a list of arguments into a stream of events
      *
-     * @param $label - The label
-     * @param $value - The value
-     * @param $option - The Option object
-     * @param $options - The map to store values
+     * Events are produced in argument order as the arguments are read, so a
+     * caller can act on each one without the whole command being collected.
+     * The arguments are read in a single forward pass; bundled short options
+     * are scanned by offset, and strings are only sliced for values kept.
+     *
+     * @param $arguments - The arguments
+     * @return - The parse events
+     * @throws \InvalidArgumentException if the arguments parameter is empty
+     * @throws \UnexpectedValueException if an unknown or ambiguous option is used or a required value is not supplied
      */
-    protected function addOption(string $label, mixed $value, Option $option, Map<string,mixed> $options): void
+    public function parseEvents(Traversable<string> $arguments): Generator<int,Event,void>
     {
-        if ($option->isMultiple()) {
-            if ($options->containsKey($label)) {
-                /* HH_IGNORE_ERROR[4006]: We know this is a Vector */
-                $options[$label][] = $option->parse($value);
-            } else {
-                $options[$label] = Vector{$option->parse($value)};
-            }
-        } else {
-            $options[$label] = $option->parse($value);
-        }
+        return $this->scan($arguments, false);
     }
 
     /**
-     * Parses a short option (e.g. `-d`)
+     * Parses a list of arguments into a proper CLI command, without throwing
      *
-     * @param $arg - The string argument
-     * @param $args - All remaining arguments
-     * @param $options - The map to store values
+     * Every error is recorded and the argument (or bundled option) with the
+     * error is skipped, so all of the errors are found in one pass, along with
+     * any broken constraints of the option set. Every value is converted
+     * while parsing, even in `LAZY` mode, so a value its type rejects is
+     * reported too, instead of throwing when it's read from the `Command`.
+     *
+     * @param $arguments - The arguments
+     * @return - The command and any errors
      */
-    protected function parseShort(string $arg, Vector<string> $args, Map<string,mixed> $options): void
+    public function tryParse(Traversable<string> $arguments): ParseResult
     {
-        $label = substr($arg, 0, 1);
-        $remainder = strlen($arg) > 1 ? substr($arg, 1) : '';
-        $value = null;
-        $option = $this->options->getOption($label);
-        if ($option === null) {
-            throw new \UnexpectedValueException("Unknown option: -$label");
-        } elseif ($option->isIncremental()) {
-            $val = (int)$options->get($label);
-            $value = $val + 1;
-        }
-        if (strlen($arg) == 1) {
-            if ($option->isRequired()) {
-                $next = $args->lastValue();
-                if ($next === null || substr($next, 0, 1) === '-') {
-                    throw new \UnexpectedValueException("Option -$label expects a value");
+        $diagnostics = Vector{};
+        $command = $this->collect($arguments, $diagnostics);
+        return new ParseResult($command, $diagnostics->immutable());
+    }
+
+    /**
+     * Reads arguments into events
+     *
+     * @param $arguments - The arguments
+     * @param $tolerant - Whether to produce error events instead of throwing
+     * @return - The parse events
+     * @throws \InvalidArgumentException if the arguments parameter is empty and errors aren't tolerated
+     * @throws \UnexpectedValueException if an unknown or ambiguous option is used or a required value is not supplied, and errors aren't tolerated
+     */
+    protected function scan(Traversable<string> $arguments, bool $tolerant): Generator<int,Event,void>
+    {
+        $program = false;
+        $options = $this->options;
+        $node = $this->commands;
+        $counts = Map{};
+        $pending = null;
+        $pendingLabel = '';
+        $pendingName = '';
+        $pendingIndex = 0;
+        $literal = false;
+        $abbreviate = ($this->mode & self::ABBREVIATE) !== 0;
+        $index = -1;
+        foreach ($arguments as $arg) {
+            $index++;
+            if (!$program) {
+                $program = true;
+                yield new Event(EventType::PROGRAM, $arg);
+                continue;
+            } elseif ($literal) {
+                yield new Event(EventType::ARGUMENT, $arg);
+                continue;
+            } elseif ($pending !== null) {
+                $id = $pending;
+                $pending = null;
+                if ($arg === '' || $arg[0] !== '-') {
+                    yield $this->check($this->createEvent($pendingLabel, $arg, $id, $options), $tolerant, $index, 0);
+                    continue;
+                }
+                $message = "Option $pendingName expects a value";
+                if (!$tolerant) {
+                    throw new \UnexpectedValueException($message);
                 }
-                $value = $args->pop();
+                yield self::createError(DiagnosticKind::MISSING_VALUE, $pendingIndex, 0, $pendingLabel, $message);
             }
-        } else {
-            if ($option->isRequired() || $option->isOptional()) {
-                $value = $remainder;
-                $remainder = '';
+            if ($arg === '--') {
+                $literal = true;
+                $node = null;
+                yield new Event(EventType::END_OF_OPTIONS);
+            } elseif ($arg === '' || $arg[0] !== '-') {
+                $node = $node === null ? null : $node->getChild($arg);
+                if ($node === null) {
+                    yield new Event(EventType::ARGUMENT, $arg);
+                } else {
+                    $options = $node->getScope();
+                    yield new Event(EventType::SUBCOMMAND, $arg);
+                }
+            } elseif (strlen($arg) > 1 && $arg[1] === '-') {
+                $eq = strpos($arg, '=', 2);
+                $label = $eq === false ? (string)substr($arg, 2) : (string)substr($arg, 2, $eq - 2);
+                if ($abbreviate) {
+                    $candidates = $this->lookupCandidates($options, $label);
+                    if ($candidates->count() > 1) {
+                        $message = "Ambiguous option: --$label could be " . implode(', ', $candidates->map($l ==> "--$l"));
+                        if (!$tolerant) {
+                            throw new \UnexpectedValueException($message);
+                        }
+                        yield self::createError(DiagnosticKind::AMBIGUOUS_OPTION, $index, 0, $label, $message);
+                        continue;
+                    } elseif ($candidates->count() === 1) {
+                        $label = $candidates[0];
+                    }
+                }
+                $id = $this->lookup($options, $label, true);
+                if ($id === null) {
+                    $message = "Unknown option: --$label";
+                    if (!$tolerant) {
+                        throw new \UnexpectedValueException($message);
+                    }
+                    yield self::createError(DiagnosticKind::UNKNOWN_OPTION, $index, 0, $label, $message);
+                    continue;
+                }
+                $flags = $options->getFlags($id);
+                if ($eq !== false) {
+                    if (($flags & (Option::REQUIRED | Option::OPTIONAL)) === 0) {
+                        $message = "Option --$label does not take a value";
+                        if (!$tolerant) {
+                            throw new \UnexpectedValueException($message);
+                        }
+                        yield self::createError(DiagnosticKind::UNEXPECTED_VALUE, $index, $eq, $label, $message);
+                        continue;
+                    }
+                    // the value ends at any further equals sign
+                    $end = strpos($arg, '=', $eq + 1);
+                    $value = $end === false ?
+                        (string)substr($arg, $eq + 1) :
+                        (string)substr($arg, $eq + 1, $end - $eq - 1);
+                    yield $this->check($this->createEvent($label, $value, $id, $options), $tolerant, $index, $eq + 1);
+                } elseif (($flags & Option::INCREMENTAL) !== 0) {
+                    $count = (int)$counts->get($label) + 1;
+                    $counts[$label] = $count;
+                    yield $this->check($this->createEvent($label, $count, $id, $options), $tolerant, $index, 0);
+                } elseif (($flags & Option::REQUIRED) !== 0) {
+                    $pending = $id;
+                    $pendingLabel = $label;
+                    $pendingName = "--$label";
+                    $pendingIndex = $index;
+                } else {
+                    yield $this->check($this->createEvent($label, '', $id, $options), $tolerant, $index, 0);
+                }
+            } else {
+                $length = strlen($arg);
+                if ($length === 1) {
+                    $message = "Unknown option: -";
+                    if (!$tolerant) {
+                        throw new \UnexpectedValueException($message);
+                    }
+                    yield self::createError(DiagnosticKind::UNKNOWN_OPTION, $index, 0, '', $message);
+                    continue;
+                }
+                for ($i = 1; $i < $length; $i++) {
+                    $label = $arg[$i];
+                    $id = $this->lookup($options, $label, false);
+                    if ($id === null) {
+                        $message = "Unknown option: -$label";
+                        if (!$tolerant) {
+                            throw new \UnexpectedValueException($message);
+                        }
+                        yield self::createError(DiagnosticKind::UNKNOWN_OPTION, $index, $i, $label, $message);
+                        continue;
+                    }
+                    $flags = $options->getFlags($id);
+                    $value = null;
+                    if (($flags & Option::INCREMENTAL) !== 0) {
+                        $value = (int)$counts->get($label) + 1;
+                        $counts[$label] = $value;
+                    }
+                    if ($i + 1 === $length) {
+                        if (($flags & Option::REQUIRED) !== 0) {
+                            $pending = $id;
+                            $pendingLabel = $label;
+                            $pendingName = "-$label";
+                            $pendingIndex = $index;
+                            break;
+                        }
+                    } elseif (($flags & (Option::REQUIRED | Option::OPTIONAL)) !== 0) {
+                        yield $this->check($this->createEvent($label, substr($arg, $i + 1), $id, $options), $tolerant, $index, $i + 1);
+                        break;
+                    }
+                    yield $this->check($this->createEvent($label, $value, $id, $options), $tolerant, $index, $i);
+                }
             }
         }
-        $this->addOption($label, $value, $option, $options);
-        if (strlen($remainder) > 0) {
-            $this->parseShort($remainder, $args, $options);
+        if (!$program) {
+            $message = "Arguments parameter must not be empty";
+            if (!$tolerant) {
+                throw new \InvalidArgumentException($message);
+            }
+            yield self::createError(DiagnosticKind::NO_ARGUMENTS, 0, 0, '', $message);
+        } elseif ($pending !== null) {
+            $message = "Option $pendingName expects a value";
+            if (!$tolerant) {
+                throw new \UnexpectedValueException($message);
+            }
+            yield self::createError(DiagnosticKind::MISSING_VALUE, $pendingIndex, 0, $pendingLabel, $message);
+        }
+    }
+
+    /**
+     * Creates an error event.
+     *
+     * @param $kind - The kind of error
+     * @param $index - The index of the argument with the error
+     * @param $offset - The byte offset of the error in the argument
+     * @param $label - The option label, if any
+     * @param $message - The error message
+     * @return - The error event, whose value is a `Diagnostic`
+     */
+    private static function createError(DiagnosticKind $kind, int $index, int $offset, string $label, string $message): Event
+    {
+        return new Event(EventType::ERROR, new Diagnostic($kind, $index, $offset, $label, $message), $label);
+    }
+
+    /**
+     * Converts the value of an option event, if errors are tolerated.
+     *
+     * @param $event - The option event
+     * @param $tolerant - Whether to produce an error event instead of throwing later
+     * @param $index - The index of the argument with the value
+     * @param $offset - The byte offset of the value in the argument
+     * @return - The option event, or an error event if its value is invalid
+     */
+    private function check(Event $event, bool $tolerant, int $index, int $offset): Event
+    {
+        if ($tolerant) {
+            try {
+                $this->convert($event);
+            } catch (\UnexpectedValueException $e) {
+                return self::createError(DiagnosticKind::INVALID_VALUE, $index, $offset, $event->getLabel(), $e->getMessage());
+            }
         }
+        return $event;
+    }
+
+    /**
+     * Finds the ID of an option by label.
+     *
+     * @param $options - The options in scope
+     * @param $label - The label, without dashes
+     * @param $long - Whether the label was given with two dashes
+     * @return - The option ID, or null if no option has the label
+     */
+    protected function lookup(OptionSet $options, string $label, bool $long): ?int
+    {
+        return $long ? $options->getLongId($label) : $options->getShortId(ord($label));
+    }
+
+    /**
+     * Finds the long labels an abbreviated label could stand for.
+     *
+     * @param $options - The options in scope
+     * @param $label - The label, without dashes
+     * @return - The candidate labels
+     */
+    protected function lookupCandidates(OptionSet $options, string $label): ImmVector<string>
+    {
+        return $options->getLongCandidates($label);
     }
 
     /**
-     * Parses a long option (e.g. `--dir`)
+     * Converts the value of an option event.
      *
-     * @param $arg - The string argument
-     * @param $args - All remaining arguments
-     * @param $options - The map to store values
+     * The event keeps the converted value, so converting it again is free.
+     *
+     * @param $event - The option event
+     * @return - The converted value
+     * @throws \UnexpectedValueException if the value is invalid
+     */
+    protected function convert(Event $event): mixed
+    {
+        return $event->getValue();
+    }
+
+    /**
+     * Creates an option event.
+     *
+     * @param $label - The label
+     * @param $value - The raw value
+     * @param $id - The option ID
+     * @param $options - The options in scope
+     * @return - The option event
      */
-    protected function parseLong(string $arg, Vector<string> $args, Map<string,mixed> $options): void
+    protected function createEvent(string $label, mixed $value, int $id, OptionSet $options): Event
     {
-        if (strpos($arg, '=') !== false) {
-            list($label, $value) = array_pad(explode('=', $arg), 2, '');
-            $option = $this->options->getOption($label);
-            if ($option === null) {
-                throw new \UnexpectedValueException("Unknown option: --$label");
-            } elseif ($option->isSolo()) {
-                throw new \UnexpectedValueException("Option --$label does not take a value");
+        return new Event(EventType::OPTION, $value, $label, $id, $options->getOptionById($id));
+    }
+
+    /**
+     * Stores an option value in its slot, taking into account multiplicity.
+     *
+     * @param $event - The option event
+     * @param $values - The value of each slot, by option ID
+     * @param $labels - The first label used for each slot
+     * @param $order - The IDs of the used slots, in the order first used
+     * @param $raw - Whether to store the unconverted value
+     */
+    protected function addOption(Event $event, Vector<mixed> $values, Vector<string> $labels, Vector<int> $order, bool $raw = false): void
+    {
+        $id = (int)$event->getOptionId();
+        $value = $raw ? $event->getRawValue() : $this->convert($event);
+        if ($id >= $labels->count()) {
+            $values->resize($id + 1, null);
+            $labels->resize($id + 1, '');
+        }
+        if ($labels[$id] === '') {
+            $labels[$id] = $event->getLabel();
+            $order[] = $id;
+        }
+        $option = $event->getOption();
+        $flags = $option === null ? 0 : $option->getFlags();
+        if ($option !== null && ($flags & (Option::MULTIPLE | Option::INCREMENTAL)) === Option::MULTIPLE) {
+            $slot = $values[$id];
+            if ($slot instanceof ValueList) {
+                $slot->add($value);
+            } else {
+                $list = new ValueList($option, $raw);
+                $list->add($value);
+                $values[$id] = $list;
             }
-            $this->addOption($label, $value, $option, $options);
+        } elseif (($flags & Option::INCREMENTAL) !== 0) {
+            $values[$id] = (int)$values[$id] + 1;
         } else {
-            $option = $this->options->getOption($arg);
-            $value = null;
-            if ($option === null) {
-                throw new \UnexpectedValueException("Unknown option: --$arg");
-            } elseif ($option->isIncremental()) {
-                $val = (int)$options->get($arg);
-                $value = $val + 1;
-            } elseif ($option->isRequired()) {
-                $next = $args->lastValue();
-                if ($next === null || substr($next, 0, 1) === '-') {
-                    throw new \UnexpectedValueException("Option --$arg expects a value");
+            $values[$id] = $value;
+        }
+    }
+
+    /**
+     * Stores an option value under the label typed, for an option used with more than one label.
+     *
+     * The first time another label is used, the values stored so far are
+     * copied to the first label.
+     *
+     * @param $event - The option event
+     * @param $first - The first label used for the option
+     * @param $values - The value of each slot, by option ID
+     * @param $aliases - The values by label of options used with more than one label
+     * @param $aliasOrder - The number of slots used when each label was first used, and the label
+     * @param $position - The number of slots used so far
+     * @param $raw - Whether to store the unconverted value
+     */
+    protected function addAlias(Event $event, string $first, Vector<mixed> $values, Map<string,mixed> $aliases, Vector<Pair<int,string>> $aliasOrder, int $position, bool $raw): void
+    {
+        $option = $event->getOption();
+        if ($option === null) {
+            return;
+        }
+        $label = $event->getLabel();
+        $slot = $values[(int)$event->getOptionId()];
+        if (!$aliases->containsKey($first)) {
+            if ($slot instanceof ValueList) {
+                $list = new ValueList($option, $raw);
+                foreach ($slot->toVector() as $v) {
+                    $list->add($v);
                 }
-                $value = $args->pop();
-            } else {
-                $value = $option->parse('');
+                $slot = $list;
             }
-            $this->addOption($arg, $value, $option, $options);
+            $aliases[$first] = $slot;
+        }
+        if (!$aliases->containsKey($label)) {
+            $aliasOrder[] = Pair{$position, $label};
+        }
+        $value = $raw ? $event->getRawValue() : $this->convert($event);
+        if (($option->getFlags() & (Option::MULTIPLE | Option::INCREMENTAL)) === Option::MULTIPLE) {
+            $list = $aliases->get($label);
+            if (!($list instanceof ValueList)) {
+                $list = new ValueList($option, $raw);
+                $aliases[$label] = $list;
+            }
+            $list->add($value);
+        } else {
+            $aliases[$label] = $value;
         }
     }
 }
@@ -0,0 +1,119 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Splits a command line string into arguments the way a POSIX shell would
+ *
+ * Words are separated by spaces, tabs, and newlines. Single quotes keep
+ * everything up to the closing quote; double quotes do the same, except that
+ * a backslash escapes `$`, `` ` ``, `"`, `\`, and a newline. Outside of quotes
+ * a backslash escapes any character. A backslash before a newline joins the
+ * lines. Nothing is expanded: `$HOME`, `*`, and `~` are kept as they are.
+ *
+ * The string is scanned once, and each word is yielded as soon as it ends,
+ * so the words can be passed straight to `Parser::parse`.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ShellWords
+{
+    /**
+     * Splits a string into words.
+     *
+     * @param $line - The command line (e.g. `test.hh -e 'a b' src`)
+     * @return - The words
+     * @throws \Cleopatra\SyntaxException if a quote is unterminated or the string ends with a backslash
+     */
+    public static function split(string $line): Generator<int,string,void>
+    {
+        $length = strlen($line);
+        $i = 0;
+        while ($i < $length) {
+            $i += strspn($line, " \t\n", $i);
+            if ($i >= $length) {
+                break;
+            } elseif ($line[$i] === '\\' && $i + 1 < $length && $line[$i + 1] === "\n") {
+                // line continuation between words
+                $i += 2;
+                continue;
+            }
+            $word = '';
+            while ($i < $length) {
+                $span = strcspn($line, " \t\n'\"\\", $i);
+                if ($span > 0) {
+                    $word .= (string)substr($line, $i, $span);
+                    $i += $span;
+                    if ($i >= $length) {
+                        break;
+                    }
+                }
+                $c = $line[$i];
+                if ($c === "'") {
+                    $end = strpos($line, "'", $i + 1);
+                    if ($end === false) {
+                        throw new SyntaxException("Unterminated single quote", $i);
+                    }
+                    $word .= (string)substr($line, $i + 1, $end - $i - 1);
+                    $i = $end + 1;
+                } elseif ($c === '"') {
+                    list($i, $quoted) = self::readDoubleQuoted($line, $i);
+                    $word .= $quoted;
+                } elseif ($c === '\\') {
+                    if ($i + 1 >= $length) {
+                        throw new SyntaxException("Unterminated escape", $i);
+                    } elseif ($line[$i + 1] !== "\n") {
+                        $word .= $line[$i + 1];
+                    }
+                    $i += 2;
+                } else {
+                    break;
+                }
+            }
+            yield $word;
+        }
+    }
+
+    /**
+     * Reads a double-quoted string.
+     *
+     * @param $line - The command line
+     * @param $start - The offset of the opening quote
+     * @return - The offset after the closing quote, and the contents
+     * @throws \Cleopatra\SyntaxException if the quote is unterminated
+     */
+    private static function readDoubleQuoted(string $line, int $start): (int, string)
+    {
+        $length = strlen($line);
+        $word = '';
+        $i = $start + 1;
+        while ($i < $length) {
+            $span = strcspn($line, "\"\\", $i);
+            $word .= (string)substr($line, $i, $span);
+            $i += $span;
+            if ($i >= $length) {
+                break;
+            } elseif ($line[$i] === '"') {
+                return tuple($i + 1, $word);
+            } elseif ($i + 1 >= $length) {
+                break;
+            }
+            $next = $line[$i + 1];
+            if ($next === "\n") {
+                // line continuation
+            } elseif (strpos('$`"\\', $next) !== false) {
+                $word .= $next;
+            } else {
+                $word .= '\\' . $next;
+            }
+            $i += 2;
+        }
+        throw new SyntaxException("Unterminated double quote", $start);
+    }
+}
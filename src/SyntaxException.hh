@@ -0,0 +1,38 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Thrown when a command line string can't be split into arguments
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class SyntaxException extends \UnexpectedValueException
+{
+    /**
+     * Creates a new SyntaxException
+     *
+     * @param $message - The error message
+     * @param $offset - The byte offset of the error in the string
+     */
+    public function __construct(string $message, private int $offset)
+    {
+        parent::__construct("$message at offset $offset");
+    }
+
+    /**
+     * Gets the byte offset of the error.
+     *
+     * @return - The offset in the string
+     */
+    public function getOffset(): int
+    {
+        return $this->offset;
+    }
+}
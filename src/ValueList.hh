@@ -0,0 +1,106 @@
+<?hh // strict
+/**
+ * Cleopatra
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+namespace Cleopatra;
+
+/**
+ * Collects the values of a multiple option while parsing
+ *
+ * The values are appended to one vector which is handed out when parsing is
+ * done, without being copied. The option can limit the number of values,
+ * skip repeated values, and share one copy of equal strings; see
+ * `Option::setLimit`, `Option::setUnique`, and `Option::setInterned`.
+ * Values are compared once converted, even when they're stored unconverted
+ * (e.g. in `Parser::LAZY` mode), so `1` and `01` are repeats for an integer
+ * option in every mode.
+ *
+ * @copyright 2016 Appertly contributors
+ * @license   MIT
+ */
+class ValueList
+{
+    private Vector<mixed> $values;
+    private int $limit;
+    private bool $unique;
+    private ?Map<arraykey,mixed> $seen;
+    private ?Option $converter;
+
+    /**
+     * Creates a new ValueList
+     *
+     * @param $option - The option whose values are collected
+     * @param $raw - Whether the values added are unconverted
+     */
+    public function __construct(Option $option, bool $raw = false)
+    {
+        $this->values = Vector{};
+        $this->limit = $option->getLimit();
+        $this->seen = $option->isUnique() || $option->isInterned() ? Map{} : null;
+        $this->unique = $option->isUnique();
+        $this->converter = $raw && $this->seen !== null ? $option : null;
+    }
+
+    /**
+     * Adds a value.
+     *
+     * @param $value - The value
+     */
+    public function add(mixed $value): void
+    {
+        if ($this->limit > 0 && $this->values->count() >= $this->limit) {
+            return;
+        }
+        $seen = $this->seen;
+        if ($seen !== null) {
+            $converter = $this->converter;
+            $key = self::key($converter === null ? $value : $converter->parse($value));
+            if ($seen->containsKey($key)) {
+                if ($this->unique) {
+                    return;
+                }
+                $value = $seen[$key];
+            } else {
+                $seen[$key] = $value;
+            }
+        }
+        $this->values[] = $value;
+    }
+
+    /**
+     * Gets the values collected.
+     *
+     * The vector is not copied; don't add to this list afterward.
+     *
+     * @return - The values
+     */
+    public function toVector(): Vector<mixed>
+    {
+        return $this->values;
+    }
+
+    /**
+     * Gets the key a value is compared by.
+     *
+     * @param $value - The value
+     * @return - The key
+     */
+    public static function key(mixed $value): arraykey
+    {
+        if (is_int($value)) {
+            return $value;
+        } elseif (is_string($value)) {
+            return "s$value";
+        } elseif (is_float($value)) {
+            return 'f' . bin2hex(pack('d', $value));
+        } elseif ($value instanceof \DateTimeInterface) {
+            return 'd' . $value->format('Y-m-d\TH:i:s.uP');
+        } elseif (is_object($value)) {
+            return 'o' . spl_object_hash($value);
+        }
+        return 'v' . (string)$value;
+    }
+}
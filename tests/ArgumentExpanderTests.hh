@@ -0,0 +1,85 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class ArgumentExpanderTests
+{
+    <<Test>>
+    public async function testExpand(Assert $assert): Awaitable<void>
+    {
+        $inner = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($inner, "-v\0--\0@literal\0");
+        $outer = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($outer, "foo\r\n\n@$inner\n");
+        $expander = new ArgumentExpander();
+        $args = Vector{};
+        foreach ($expander->expand(['@test.hh', 'a', "@$outer", 'b', '@x']) as $arg) {
+            $args[] = $arg;
+        }
+        unlink($inner);
+        unlink($outer);
+        $assert->mixed($args)->looselyEquals(Vector{'@test.hh', 'a', 'foo', '-v', '--', '@literal', 'b', '@x'});
+    }
+
+    <<Test>>
+    public async function testArgsFrom(Assert $assert): Awaitable<void>
+    {
+        $file = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($file, "1.txt\n2.txt");
+        $parser = new Parser(new OptionSet(new Option("q|quiet", "Quiet")));
+        $expander = new ArgumentExpander();
+        $cmd = $parser->parse($expander->expand(['test.hh', '-q', '--args-from', $file, "--args-from=$file"]));
+        unlink($file);
+        $assert->mixed($cmd->getArguments())->looselyEquals(ImmVector{'1.txt', '2.txt', '1.txt', '2.txt'});
+    }
+
+    <<Test>>
+    public async function testArgsFromLiteral(Assert $assert): Awaitable<void>
+    {
+        $inner = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($inner, "-v\n");
+        $file = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($file, "a\0\0@$inner\0--args-from=$inner\0--\0");
+        $expander = new ArgumentExpander();
+        $args = Vector{};
+        foreach ($expander->expand(['test.hh', '--args-from', $file, '--', '@b']) as $arg) {
+            $args[] = $arg;
+        }
+        unlink($inner);
+        unlink($file);
+        $assert->mixed($args)->looselyEquals(
+            Vector{'test.hh', 'a', '', "@$inner", "--args-from=$inner", '--', '--', '@b'}
+        );
+    }
+
+    <<Test>>
+    public async function testEmptyRecords(Assert $assert): Awaitable<void>
+    {
+        $nul = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($nul, "\0a\0\0");
+        $lines = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($lines, "\na\n\n");
+        $expander = new ArgumentExpander();
+        $args = Vector{};
+        foreach ($expander->expand(['test.hh', "@$nul", "@$lines"]) as $arg) {
+            $args[] = $arg;
+        }
+        unlink($nul);
+        unlink($lines);
+        $assert->mixed($args)->looselyEquals(Vector{'test.hh', '', 'a', '', 'a'});
+    }
+
+    <<Test>>
+    public async function testRecursive(Assert $assert): Awaitable<void>
+    {
+        $file = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($file, "@$file");
+        $expander = new ArgumentExpander();
+        $assert->whenCalled(() ==> {foreach ($expander->expand(['test.hh', "@$file"]) as $arg) {}})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                "Response file includes itself: $file");
+        unlink($file);
+    }
+}
@@ -0,0 +1,124 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class CodeGeneratorTests
+{
+    <<Test>>
+    public async function testGenerate(Assert $assert): Awaitable<void>
+    {
+        $parser = $this->load('GeneratedTwoParser', new OptionSet(
+            new Option("h|help", ""),
+            new Option("v|verbose+", ""),
+            new Option("e|exclude:s@", ""),
+            new Option("nice:i", ""),
+            new Option("profile:", ""),
+            new Option("q|quiet", ""),
+            new Option("x|experimental", ""),
+            new Option("log::", "")
+        ));
+        $args = ['test.php', '-qe', 'foo', '-e', 'bar', '--nice', '123', 'run-tests', '-vvv', '-v', '--log=syslog', '-v', '-xebaz', 'src'];
+        $result = $parser->parse($args);
+        $assert->string($result->program)->is('test.php');
+        $assert->int($result->v)->eq(5);
+        $assert->mixed($result->nice)->identicalTo(123);
+        $assert->mixed($result->toCommand()->getOptions())->looselyEquals(Map{'q' => true, 'e' => Vector{'foo', 'bar', 'baz'}, 'nice' => 123, 'v' => 5, 'log' => 'syslog', 'x' => true});
+        $assert->mixed($result->arguments)->looselyEquals(Vector{'run-tests', 'src'});
+    }
+
+    <<Test>>
+    public async function testGenerateValueLists(Assert $assert): Awaitable<void>
+    {
+        $parser = $this->load('GeneratedValueListParser', new OptionSet(
+            (new Option("e|exclude:@", ""))->setUnique(),
+            (new Option("f|file:@", ""))->setLimit(2),
+            (new Option("n|number:i@", ""))->setInterned(),
+            (new Option("r|ratio:f@", ""))->setUnique()
+        ));
+        $result = $parser->parse(['test.hh', '-e', 'a', '-eb', '--exclude=a', '-f', 'x', '-f', 'y', '-f', 'z', '-n1', '-n', '1', '-r', '0.30000000000000004', '-r', '0.3', '-r', '3e-1']);
+        $assert->mixed($result->e)->looselyEquals(Vector{'a', 'b'});
+        $assert->mixed($result->f)->looselyEquals(Vector{'x', 'y'});
+        $assert->mixed($result->n)->looselyEquals(Vector{1, 1});
+        $assert->mixed($result->r)->looselyEquals(Vector{0.1 + 0.2, 0.3});
+    }
+
+    <<Test>>
+    public async function testGenerateConstraints(Assert $assert): Awaitable<void>
+    {
+        $parser = $this->load('GeneratedConstraintParser', (new OptionSet(
+            new Option("q|quiet", ""),
+            new Option("v|verbose+", ""),
+            new Option("user:", ""),
+            new Option("password:", ""),
+            new Option("f|file:@", ""),
+            new Option("stdin", "")
+        ))->exclusive('quiet', 'verbose')->requires('user', 'password')->atLeastOne('file', 'stdin'));
+        $assert->whenCalled(() ==> {$parser->parse(['test.hh', '-qv', '--user', 'me']);})
+            ->willThrowClassWithMessage(ConstraintException::class,
+                'Options -q and -v cannot be used together' . PHP_EOL .
+                'Option --user requires --password' . PHP_EOL .
+                'One of -f, --stdin is required');
+        $result = $parser->parse(['test.hh', '-v', '--stdin']);
+        $assert->int($result->v)->eq(1);
+    }
+
+    <<Test>>
+    public async function testGenerateNumericLabels(Assert $assert): Awaitable<void>
+    {
+        $parser = $this->load('GeneratedNumericParser', new OptionSet(
+            new Option("10|ten", ""),
+            new Option("1|one", "")
+        ));
+        $result = $parser->parse(['test.hh', '--10', '--1', '-1']);
+        $assert->bool($result->option10)->is(true);
+        $assert->bool($result->option1)->is(true);
+        $assert->whenCalled(() ==> {$parser->parse(['test.hh', '--010']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: --010');
+        $assert->whenCalled(() ==> {$parser->parse(['test.hh', '--1.0']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: --1.0');
+    }
+
+    <<Test>>
+    public async function testGenerateErrors(Assert $assert): Awaitable<void>
+    {
+        $parser = $this->load('GeneratedErrorParser', new OptionSet(
+            new Option("d|directory:", "This is the name of the directory you wish to be parsed"),
+            new Option("v|verbose", "Verbosity")
+        ));
+        $assert->whenCalled(() ==> {$parser->parse([]);})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Arguments parameter must not be empty');
+        $assert->whenCalled(() ==> {$parser->parse(['test.php', '-x']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: -x');
+        $assert->whenCalled(() ==> {$parser->parse(['test.php', '--foo']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: --foo');
+        $assert->whenCalled(() ==> {$parser->parse(['test.php', '-d', '--', 'bar']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Option -d expects a value');
+        $assert->whenCalled(() ==> {$parser->parse(['test.php', '--directory']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Option --directory expects a value');
+        $assert->whenCalled(() ==> {$parser->parse(['test.php', '--verbose=yes']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Option --verbose does not take a value');
+        $result = $parser->parse(['test.hh', '-v', '--', 'src', 'tests']);
+        $assert->bool($result->v)->is(true);
+        $assert->mixed($result->arguments)->looselyEquals(Vector{'src', 'tests'});
+    }
+
+    private function load(string $class, OptionSet $set): mixed
+    {
+        $file = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($file, (new CodeGenerator($set))->generate($class, 'Cleopatra\Generated'));
+        require_once $file;
+        unlink($file);
+        $class = "Cleopatra\\Generated\\$class";
+        return new $class();
+    }
+}
@@ -0,0 +1,71 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class CommandNodeTests
+{
+    <<Test>>
+    public async function testParse(Assert $assert): Awaitable<void>
+    {
+        $built = Vector{};
+        $root = new CommandNode(() ==> new OptionSet(
+            new Option("profile:", "The profile"),
+            new Option("v|verbose+", "Verbosity")
+        ));
+        $ec2 = new CommandNode(() ==> {
+            $built[] = 'ec2';
+            return new OptionSet(new Option("region:", "The region"));
+        });
+        $ec2->add('start-instances', new CommandNode(() ==> {
+            $built[] = 'start-instances';
+            return new OptionSet(new Option("instance-ids:@", "The instances"));
+        }));
+        $root->add('ec2', $ec2);
+        $root->add('s3', new CommandNode(() ==> {
+            $built[] = 's3';
+            return new OptionSet(new Option("bucket:", "The bucket"));
+        }));
+        $parser = Parser::forCommands($root);
+        $cmd = $parser->parse(['aws', '--profile', 'mine', 'ec2', 'start-instances', '--instance-ids', 'i-123456', '-v', 'ec2', '--region=us-east-1']);
+        $assert->mixed($cmd->getSubcommands())->looselyEquals(ImmVector{'ec2', 'start-instances'});
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'profile' => 'mine', 'instance-ids' => Vector{'i-123456'}, 'v' => 1, 'region' => 'us-east-1'});
+        $assert->mixed($cmd->getArguments())->looselyEquals(ImmVector{'ec2'});
+        $assert->mixed($built)->looselyEquals(Vector{'ec2', 'start-instances'});
+    }
+
+    <<Test>>
+    public async function testGroup(Assert $assert): Awaitable<void>
+    {
+        $root = new CommandNode(() ==> new OptionSet(new Option("profile:", "The profile")));
+        $ec2 = new CommandNode(null, 'Amazon EC2');
+        $ec2->add('start-instances', new CommandNode(() ==> new OptionSet(new Option("instance-ids:@", "The instances"))));
+        $root->add('ec2', $ec2);
+        $assert->mixed($ec2->getOptions())->isNull();
+        $assert->mixed($ec2->getScope())->identicalTo($root->getScope());
+        $cmd = Parser::forCommands($root)->parse(['aws', 'ec2', '--profile', 'mine', 'start-instances', '--instance-ids', 'i-123456']);
+        $assert->mixed($cmd->getSubcommands())->looselyEquals(ImmVector{'ec2', 'start-instances'});
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'profile' => 'mine', 'instance-ids' => Vector{'i-123456'}});
+        $assert->whenCalled(() ==> {(new CommandNode(null))->getScope();})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'The root command must have options');
+    }
+
+    <<Test>>
+    public async function testScope(Assert $assert): Awaitable<void>
+    {
+        $root = new CommandNode(() ==> new OptionSet(new Option("q|quiet", "Quiet")));
+        $root->add('ls', new CommandNode(() ==> new OptionSet(new Option("l|long", "Long"))));
+        $parser = Parser::forCommands($root);
+        $assert->whenCalled(() ==> {$parser->parse(['git', '-l', 'ls']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: -l');
+        $cmd = $parser->parse(['git', '--', 'ls', '-l']);
+        $assert->container($cmd->getSubcommands())->isEmpty();
+        $assert->mixed($cmd->getArguments())->looselyEquals(ImmVector{'ls', '-l'});
+        $assert->whenCalled(() ==> {$root->add('ls', new CommandNode(() ==> new OptionSet(new Option("a", "All"))));})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Duplicate subcommand: ls');
+    }
+}
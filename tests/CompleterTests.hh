@@ -0,0 +1,72 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class CompleterTests
+{
+    <<Test>>
+    public async function testLongPrefix(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(
+            new Option("v|verbose+", "Verbose mode"),
+            new Option("version", "Show the version"),
+            new Option("d|directory:", "The directory")
+        );
+        $completer = new Completer($set);
+        $completion = $completer->complete(['prog', '--ver'], 1);
+        $assert->mixed($completion->getCandidates()->toArray())->looselyEquals(['--verbose', '--version']);
+        $assert->bool($completion->expectsValue())->is(false);
+        $completion = $completer->complete(['prog', '--d'], 1);
+        $assert->mixed($completion->getCandidates()->toArray())->looselyEquals(['--directory']);
+        $assert->bool($completion->takesValue('--directory'))->is(true);
+        $assert->int($set->getLabelTrie()->count('ver'))->eq(2);
+        $assert->int($set->getLabelTrie()->count('x'))->eq(0);
+    }
+
+    <<Test>>
+    public async function testValues(Assert $assert): Awaitable<void>
+    {
+        $directory = new Option("d|directory:", "The directory");
+        $completer = new Completer(new OptionSet(new Option("v|verbose+", "Verbose mode"), $directory));
+        $assert->mixed($completer->complete(['prog', '-vd', ''], 2)->getValueOption())->identicalTo($directory);
+        $assert->mixed($completer->complete(['prog', '--directory', 'sr'], 2)->getValueOption())->identicalTo($directory);
+        $assert->mixed($completer->complete(['prog', '--directory=sr'], 1)->getValueOption())->identicalTo($directory);
+        $assert->mixed($completer->complete(['prog', '-dsr'], 1)->getValueOption())->identicalTo($directory);
+        $assert->bool($completer->complete(['prog', '--', '--d'], 2)->getCandidates()->isEmpty())->is(true);
+        $completion = $completer->complete(['prog', '--=sr'], 1);
+        $assert->bool($completion->getCandidates()->isEmpty())->is(true);
+        $assert->mixed($completion->getValueOption())->isNull();
+        $assert->mixed($completer->complete(['prog', '--=sr', '--d'], 2)->getCandidates()->toArray())->looselyEquals(['--directory']);
+    }
+
+    <<Test>>
+    public async function testSubcommands(Assert $assert): Awaitable<void>
+    {
+        $root = new CommandNode(() ==> new OptionSet(new Option("profile:", "The profile")));
+        $ec2 = new CommandNode(() ==> new OptionSet(new Option("region:", "The region")));
+        $ec2->add('start-instances', new CommandNode(() ==> new OptionSet(new Option("dry-run", "Dry run"))));
+        $ec2->add('stop-instances', new CommandNode(() ==> new OptionSet(new Option("force", "Force"))));
+        $root->add('ec2', $ec2);
+        $completer = Completer::forCommands($root);
+        $completion = $completer->complete(['aws', '--profile', 'me', 'ec2', 'st'], 4);
+        $assert->mixed($completion->getCandidates()->toArray())->looselyEquals(['start-instances', 'stop-instances']);
+        $completion = $completer->complete(['aws', 'ec2', '--re'], 2);
+        $assert->mixed($completion->getCandidates()->toArray())->looselyEquals(['--region']);
+    }
+
+    <<Test>>
+    public async function testScripts(Assert $assert): Awaitable<void>
+    {
+        $bash = Completer::getScript('bash', 'my-prog');
+        $assert->string($bash)->contains("complete -F _my_prog_complete 'my-prog'");
+        $assert->string($bash)->contains('_get_comp_words_by_ref -n = -c cur -w words -i cword');
+        $assert->bool(strpos($bash, 'COMP_WORDS') === false)->is(true);
+        $assert->string(Completer::getScript('zsh', 'my-prog'))->contains("compdef _my_prog_complete 'my-prog'");
+        $assert->string(Completer::getScript('fish', 'my-prog'))->contains("complete -c 'my-prog'");
+        $assert->whenCalled(() ==> {Completer::getScript('tcsh', 'my-prog');})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Unsupported shell: tcsh');
+    }
+}
@@ -0,0 +1,58 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class ConverterRegistryTests
+{
+    <<Test>>
+    public async function testBuiltIns(Assert $assert): Awaitable<void>
+    {
+        $assert->mixed(ConverterRegistry::convert('bytes', '512'))->identicalTo(512);
+        $assert->mixed(ConverterRegistry::convert('bytes', '10K'))->identicalTo(10240);
+        $assert->mixed(ConverterRegistry::convert('bytes', '1.5GiB'))->identicalTo(1610612736);
+        $assert->mixed(ConverterRegistry::convert('duration', '1h30m'))->identicalTo(5400.0);
+        $assert->mixed(ConverterRegistry::convert('duration', '250ms'))->identicalTo(0.25);
+        $assert->mixed(ConverterRegistry::convert('path', __DIR__ . '/../src'))->identicalTo(realpath(__DIR__ . '/../src'));
+        $assert->whenCalled(() ==> {ConverterRegistry::convert('bytes', '10X');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class, 'Invalid byte size: 10X');
+        $assert->whenCalled(() ==> {ConverterRegistry::convert('duration', '1h30');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class, 'Invalid duration: 1h30');
+    }
+
+    <<Test>>
+    public async function testRegister(Assert $assert): Awaitable<void>
+    {
+        ConverterRegistry::registerEnum('test-color', ['auto', 'always', 'never']);
+        ConverterRegistry::registerPattern('test-semver', '/^\d+\.\d+\.\d+$/');
+        $assert->bool(ConverterRegistry::has('test-color'))->is(true);
+        $assert->mixed(ConverterRegistry::convert('test-color', 'never'))->identicalTo('never');
+        $assert->mixed(ConverterRegistry::convert('test-semver', '1.2.3'))->identicalTo('1.2.3');
+        $assert->whenCalled(() ==> {ConverterRegistry::convert('test-color', 'blue');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Invalid test-color: blue (expected one of auto, always, never)');
+        $assert->whenCalled(() ==> {ConverterRegistry::register('bytes', $v ==> $v);})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Cannot replace a built-in value type: bytes');
+        $assert->whenCalled(() ==> {new Option('x:test-nope', 'Nope');})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Unknown value type: test-nope');
+    }
+
+    <<Test>>
+    public async function testParse(Assert $assert): Awaitable<void>
+    {
+        ConverterRegistry::registerEnum('test-level', ['low', 'high']);
+        $parser = new Parser(new OptionSet(
+            new Option('s|size:bytes', 'Size'),
+            new Option('t|timeout::duration', 'Timeout'),
+            new Option('l|level:test-level@', 'Levels')
+        ));
+        $cmd = $parser->parse(['test.hh', '-s', '2M', '--timeout=90s', '-l', 'low', '--level', 'high']);
+        $assert->mixed($cmd->getOption('size'))->identicalTo(2097152);
+        $assert->mixed($cmd->getOption('timeout'))->identicalTo(90.0);
+        $assert->mixed($cmd->getVector('level'))->looselyEquals(ImmVector{'low', 'high'});
+        $assert->string((new Option('s|size:bytes', 'Size'))->getType())->is('bytes');
+    }
+}
@@ -0,0 +1,70 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class DateConverterTests
+{
+    <<Test>>
+    public async function testIso8601(Assert $assert): Awaitable<void>
+    {
+        $converter = new DateConverter(DateConverter::ISO8601, 'America/New_York');
+        $assert->string($converter->convert('2016-04-01')->format(DATE_ATOM))->is('2016-04-01T00:00:00-04:00');
+        $assert->string($converter->convert('2016-04-01T12:30')->format(DATE_ATOM))->is('2016-04-01T12:30:00-04:00');
+        $assert->string($converter->convert('2016-04-01T12:30:15Z')->format(DATE_ATOM))->is('2016-04-01T12:30:15+00:00');
+        $assert->string($converter->convert('2016-04-01 12:30:15.25+0530')->format('Y-m-d H:i:s.u P'))
+            ->is('2016-04-01 12:30:15.250000 +05:30');
+        $assert->mixed($converter->convert('2016-04-01'))->identicalTo($converter->convert('2016-04-01'));
+        $assert->whenCalled(() ==> {$converter->convert('2016-02-30');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class, 'Invalid date: 2016-02-30 (expected iso8601)');
+        $assert->whenCalled(() ==> {$converter->convert('tomorrow');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class, 'Invalid date: tomorrow (expected iso8601)');
+    }
+
+    <<Test>>
+    public async function testEpoch(Assert $assert): Awaitable<void>
+    {
+        $converter = new DateConverter(DateConverter::EPOCH, 'Europe/Paris');
+        $date = $converter->convert('1459513800.5');
+        $assert->int($date->getTimestamp())->eq(1459513800);
+        $assert->string($date->format('Y-m-d H:i:s.u P'))->is('2016-04-01 14:30:00.500000 +02:00');
+        $date = $converter->convert('-1.5');
+        $assert->int($date->getTimestamp())->eq(-2);
+        $assert->string($date->format('u'))->is('500000');
+        $date = $converter->convert('-0.25');
+        $assert->int($date->getTimestamp())->eq(-1);
+        $assert->string($date->format('u'))->is('750000');
+        $assert->int($converter->convert('-2.0')->getTimestamp())->eq(-2);
+        $assert->whenCalled(() ==> {$converter->convert('1e9');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class, 'Invalid date: 1e9 (expected epoch)');
+    }
+
+    <<Test>>
+    public async function testFormat(Assert $assert): Awaitable<void>
+    {
+        $converter = new DateConverter('d/m/Y', 'UTC', 0);
+        $assert->string($converter->convert('01/04/2016')->format(DATE_ATOM))->is('2016-04-01T00:00:00+00:00');
+        $assert->mixed($converter->convert('01/04/2016'))->looselyEquals($converter->convert('01/04/2016'));
+        $assert->whenCalled(() ==> {new DateConverter('Y-m-d', 'Nowhere/Special');})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class, 'Unknown timezone: Nowhere/Special');
+    }
+
+    <<Test>>
+    public async function testParse(Assert $assert): Awaitable<void>
+    {
+        ConverterRegistry::registerDate('test-day', 'd/m/Y', 'Europe/Paris');
+        $parser = new Parser(new OptionSet(
+            new Option('since:iso8601@', 'Since'),
+            new Option('on:test-day', 'On')
+        ));
+        $cmd = $parser->parse(['test.hh', '--since', '2016-04-01', '--since=2016-04-01', '--on', '02/04/2016']);
+        $since = $cmd->getVector('since');
+        $assert->int($since->count())->eq(2);
+        $assert->mixed($since[0])->identicalTo($since[1]);
+        $assert->string($since[0]->format(DATE_ATOM))->is('2016-04-01T00:00:00+00:00');
+        $on = $cmd->getOption('on');
+        $assert->bool($on instanceof \DateTimeImmutable)->is(true);
+        $assert->string($on instanceof \DateTimeImmutable ? $on->format(DATE_ATOM) : '')->is('2016-04-02T00:00:00+02:00');
+    }
+}
@@ -0,0 +1,112 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class FallbackResolverTests
+{
+    <<Test>>
+    public async function testPrecedence(Assert $assert): Awaitable<void>
+    {
+        // the extension picks the format, so the files sit next to the ones tempnam reserves
+        $iniBase = tempnam(sys_get_temp_dir(), 'cleo');
+        $ini = "$iniBase.ini";
+        file_put_contents($ini, "nice = 5\n[server]\nport = 8080\nprofile = ini\n");
+        $jsonBase = tempnam(sys_get_temp_dir(), 'cleo');
+        $json = "$jsonBase.json";
+        file_put_contents($json, '{"server": {"port": 9090, "hosts": ["a", "b"]}, "quiet": true}');
+        $set = new OptionSet(
+            new Option("p|profile:", "The profile"),
+            new Option("port:i", "The port"),
+            new Option("n|nice:i", "Nice value"),
+            new Option("h|host:@", "The hosts"),
+            new Option("q|quiet", "Quiet"),
+            new Option("x|experimental", "Experimental"),
+            new Option("level:i", "The level")
+        );
+        $resolver = (new FallbackResolver($set))
+            ->env('profile', 'CLEOPATRA_TEST_PROFILE')
+            ->env('nice', 'CLEOPATRA_TEST_NICE')
+            ->env('experimental', 'CLEOPATRA_TEST_EXPERIMENTAL')
+            ->config('profile', 'server.profile')
+            ->config('port', 'server.port')
+            ->config('nice', 'nice')
+            ->config('host', 'server.hosts')
+            ->config('quiet', 'quiet')
+            ->defaultValue('level', '3')
+            ->addConfigFile('/nonexistent/cleopatra.ini')
+            ->addConfigFile($ini)
+            ->addConfigFile($json);
+        putenv('CLEOPATRA_TEST_NICE=7');
+        putenv('CLEOPATRA_TEST_EXPERIMENTAL=0');
+        $cmd = $resolver->resolve((new Parser($set))->parse(['test.hh', '--profile', 'argv']));
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{
+            'profile' => 'argv', 'port' => 8080, 'n' => 7, 'h' => Vector{'a', 'b'}, 'q' => true, 'level' => 3
+        });
+        $assert->int($cmd->getInt('nice'))->eq(7);
+        $assert->bool($cmd->hasOption('experimental'))->is(false);
+        putenv('CLEOPATRA_TEST_NICE');
+        putenv('CLEOPATRA_TEST_EXPERIMENTAL');
+        unlink($ini);
+        unlink($iniBase);
+        unlink($json);
+        unlink($jsonBase);
+    }
+
+    <<Test>>
+    public async function testConstraints(Assert $assert): Awaitable<void>
+    {
+        $set = (new OptionSet(
+            new Option("f|file:", "The file"),
+            new Option("stdin", "Read stdin"),
+            new Option("q|quiet", "Quiet"),
+            new Option("v|verbose", "Verbose")
+        ))->atLeastOne('file', 'stdin')->exclusive('quiet', 'verbose');
+        $resolver = (new FallbackResolver($set))
+            ->env('file', 'CLEOPATRA_TEST_FILE')
+            ->env('quiet', 'CLEOPATRA_TEST_QUIET');
+        $parser = new Parser($set, Parser::DEFER_CONSTRAINTS);
+        $assert->whenCalled(() ==> {(new Parser($set))->parse(['test.hh']);})
+            ->willThrowClassWithMessage(ConstraintException::class,
+                'One of -f, --stdin is required');
+        $assert->whenCalled(() ==> {$resolver->resolve($parser->parse(['test.hh']));})
+            ->willThrowClassWithMessage(ConstraintException::class,
+                'One of -f, --stdin is required');
+        putenv('CLEOPATRA_TEST_FILE=input.txt');
+        putenv('CLEOPATRA_TEST_QUIET=1');
+        $cmd = $resolver->resolve($parser->parse(['test.hh']));
+        $assert->string($cmd->getString('file'))->is('input.txt');
+        $assert->bool($cmd->hasOption('quiet'))->is(true);
+        $cmd = $resolver->resolve($parser->parse(['test.hh', '-v']));
+        $assert->bool($cmd->hasOption('quiet'))->is(false);
+        $assert->bool($cmd->hasOption('verbose'))->is(true);
+        putenv('CLEOPATRA_TEST_FILE');
+        putenv('CLEOPATRA_TEST_QUIET');
+    }
+
+    <<Test>>
+    public async function testConfigFileChanged(Assert $assert): Awaitable<void>
+    {
+        $ini = tempnam(sys_get_temp_dir(), 'cleo');
+        file_put_contents($ini, "nice = 1\n");
+        $mtime = filemtime($ini);
+        $assert->mixed(ConfigFile::load($ini))->looselyEquals(ImmMap{'nice' => '1'});
+        file_put_contents($ini, "nice = 2\n");
+        touch($ini, $mtime);
+        $assert->mixed(ConfigFile::load($ini))->looselyEquals(ImmMap{'nice' => '2'});
+        unlink($ini);
+    }
+
+    <<Test>>
+    public async function testUnknown(Assert $assert): Awaitable<void>
+    {
+        $resolver = new FallbackResolver(new OptionSet(new Option("q|quiet", "Quiet")));
+        $assert->whenCalled(() ==> {$resolver->env('nope', 'NOPE');})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Unknown option: nope');
+        $assert->whenCalled(() ==> {ConfigFile::load('/nonexistent/cleopatra.json');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Cannot read config file: /nonexistent/cleopatra.json');
+    }
+}
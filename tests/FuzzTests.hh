@@ -0,0 +1,198 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class FuzzTests
+{
+    const int SEED = 20160401;
+
+    <<Test>>
+    public async function testRoundTrip(Assert $assert): Awaitable<void>
+    {
+        mt_srand(self::SEED);
+        $parser = new Parser(self::optionSet());
+        for ($round = 0; $round < 200; $round++) {
+            $argv = ['test.hh'];
+            $verbose = 0;
+            $quiet = false;
+            $exclude = Vector{};
+            $nice = null;
+            $log = null;
+            $arguments = Vector{};
+            $bundle = -1;
+            $uses = mt_rand(0, 20);
+            for ($i = 0; $i < $uses; $i++) {
+                $word = 'w' . mt_rand(0, 999);
+                switch (mt_rand(0, 5)) {
+                    case 0:
+                        $verbose++;
+                        self::addFlag($argv, $bundle, 'v', 'verbose');
+                        break;
+                    case 1:
+                        $quiet = true;
+                        self::addFlag($argv, $bundle, 'q', 'quiet');
+                        break;
+                    case 2:
+                        $exclude[] = $word;
+                        self::addValue($argv, $bundle, 'e', 'exclude', $word);
+                        break;
+                    case 3:
+                        $nice = mt_rand(0, 20);
+                        self::addValue($argv, $bundle, 'n', 'nice', (string)$nice);
+                        break;
+                    case 4:
+                        $log = mt_rand(0, 1) === 0 ? '' : $word;
+                        self::addOptional($argv, $bundle, 'l', 'log', $log);
+                        break;
+                    default:
+                        $arguments[] = $word;
+                        $argv[] = $word;
+                        $bundle = -1;
+                        break;
+                }
+            }
+            $cmd = $parser->parse($argv);
+            $assert->int($cmd->getCount('verbose'))->eq($verbose);
+            $assert->bool($cmd->hasOption('quiet'))->is($quiet);
+            $assert->mixed($cmd->getVector('exclude'))->looselyEquals($exclude->immutable());
+            $assert->mixed($cmd->getOption('nice'))->identicalTo($nice);
+            $assert->mixed($cmd->getOption('log'))->identicalTo($log);
+            $assert->mixed($cmd->getArguments())->looselyEquals($arguments->immutable());
+            $result = $parser->tryParse($argv);
+            $assert->bool($result->isValid())->is(true);
+            $assert->mixed($result->getCommand()->getOptions())->looselyEquals($cmd->getOptions());
+            $quoted = implode(' ', array_map($a ==> escapeshellarg($a), $argv));
+            $assert->mixed(new Vector(ShellWords::split($quoted)))->looselyEquals(new Vector($argv));
+        }
+    }
+
+    <<Test>>
+    public async function testHugeBundle(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(self::optionSet());
+        $cmd = $parser->parse(['test.hh', '-' . str_repeat('v', 80000)]);
+        $assert->int($cmd->getCount('v'))->eq(80000);
+    }
+
+    <<Test>>
+    public async function testManyEquals(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(self::optionSet());
+        $n = 400000;
+        $cmd = $parser->parse(['test.hh', '--log=a' . str_repeat('=', $n), '-e', str_repeat('=', $n)]);
+        $assert->mixed($cmd->getOption('log'))->identicalTo('a');
+        $assert->mixed($cmd->getVector('exclude'))->looselyEquals(ImmVector{str_repeat('=', $n)});
+    }
+
+    <<Test>>
+    public async function testLongLabels(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(self::optionSet(), Parser::ABBREVIATE);
+        $label = str_repeat('x', 400000);
+        $result = $parser->tryParse(['test.hh', "--$label", "--$label=1", '--' . str_repeat('e', 400000)]);
+        $assert->int($result->getDiagnostics()->count())->eq(3);
+    }
+
+    <<Test>>
+    public async function testManyDoubleDashes(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(self::optionSet());
+        $start = memory_get_usage();
+        $peak = 0;
+        $i = 0;
+        foreach ($parser->parseEvents(self::repeat('--', 1000000)) as $event) {
+            if (++$i % 10000 === 0) {
+                $peak = max($peak, memory_get_usage() - $start);
+            }
+        }
+        $assert->int($i)->eq(1000001);
+        $assert->int($peak)->lt(1048576);
+    }
+
+    <<Test>>
+    public async function testLongQuotes(Assert $assert): Awaitable<void>
+    {
+        $n = 400000;
+        $line = "test.hh '" . str_repeat('a', $n) . "' \"" . str_repeat('\\"', $n) . '" ' . str_repeat('b\\ ', $n);
+        $words = new Vector(ShellWords::split($line));
+        $assert->mixed($words)->looselyEquals(
+            Vector{'test.hh', str_repeat('a', $n), str_repeat('"', $n), str_repeat('b ', $n)}
+        );
+    }
+
+    private static function repeat(string $arg, int $n): Generator<int,string,void>
+    {
+        yield 'test.hh';
+        for ($i = 0; $i < $n; $i++) {
+            yield $arg;
+        }
+    }
+
+    private static function addFlag(array<string> &$argv, int &$bundle, string $short, string $long): void
+    {
+        switch (mt_rand(0, 2)) {
+            case 0:
+                $argv[] = "--$long";
+                $bundle = -1;
+                break;
+            case 1:
+                if ($bundle >= 0) {
+                    $argv[$bundle] .= $short;
+                    break;
+                }
+                // FALLTHROUGH
+            default:
+                $argv[] = "-$short";
+                $bundle = count($argv) - 1;
+                break;
+        }
+    }
+
+    private static function addValue(array<string> &$argv, int &$bundle, string $short, string $long, string $value): void
+    {
+        switch (mt_rand(0, 3)) {
+            case 0:
+                $argv[] = "--$long";
+                $argv[] = $value;
+                break;
+            case 1:
+                $argv[] = "--$long=$value";
+                break;
+            case 2:
+                $argv[] = "-$short";
+                $argv[] = $value;
+                break;
+            default:
+                if ($bundle >= 0) {
+                    $argv[$bundle] .= "$short$value";
+                } else {
+                    $argv[] = "-$short$value";
+                }
+                break;
+        }
+        $bundle = -1;
+    }
+
+    private static function addOptional(array<string> &$argv, int &$bundle, string $short, string $long, string $value): void
+    {
+        if ($value === '') {
+            $argv[] = mt_rand(0, 1) === 0 ? "--$long" : "-$short";
+        } else {
+            $argv[] = mt_rand(0, 1) === 0 ? "--$long=$value" : "-$short$value";
+        }
+        $bundle = -1;
+    }
+
+    private static function optionSet(): OptionSet
+    {
+        return new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("q|quiet", "Quiet"),
+            new Option("e|exclude:@", "Excludes"),
+            new Option("n|nice:i", "Nice value"),
+            new Option("l|log::", "Log file")
+        );
+    }
+}
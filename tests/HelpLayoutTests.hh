@@ -0,0 +1,46 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class HelpLayoutTests
+{
+    <<Test>>
+    public async function testWidth(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(
+            new Option("d|directory", "The name of the directory to parse"),
+            new Option("q", "Quiet")
+        );
+        $out =  "  -d --directory  The name of the" . PHP_EOL .
+                "                  directory to parse" . PHP_EOL .
+                "  -q              Quiet" . PHP_EOL;
+        $assert->string($set->getHelpLayout()->toString(40))->is($out);
+        $assert->mixed($set->getHelpLayout())->identicalTo($set->getHelpLayout());
+    }
+
+    <<Test>>
+    public async function testSections(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(
+            new Option("d|directory", "The directory"),
+            new Option("v|verbose+", "Verbose mode"),
+            new Option("q|quiet", "Quiet mode")
+        );
+        $layout = $set->getHelpLayout()->withSections(Map{'Output' => Vector{'quiet', 'v'}});
+        $out =  "  -d --directory  The directory" . PHP_EOL .
+                PHP_EOL .
+                "Output:" . PHP_EOL .
+                "  -q --quiet      Quiet mode" . PHP_EOL .
+                "  -v --verbose    Verbose mode" . PHP_EOL;
+        $handle = fopen('php://memory', 'w+');
+        $layout->write($handle, 80);
+        rewind($handle);
+        $assert->string(stream_get_contents($handle))->is($out);
+        fclose($handle);
+        $assert->whenCalled(() ==> {$set->getHelpLayout()->withSections(Map{'A' => Vector{'nope'}});})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Unknown option: nope');
+    }
+}
@@ -0,0 +1,98 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class OptionSetCacheTests
+{
+    <<Test>>
+    public async function testRoundTrip(Assert $assert): Awaitable<void>
+    {
+        $options = self::optionSet();
+        $snapshot = OptionSetCache::export($options, '1.0');
+        $loaded = OptionSetCache::import($snapshot, '1.0', self::specs());
+        $assert->int($loaded->count())->eq(4);
+        $assert->mixed($loaded->getLongId('size'))->identicalTo(3);
+        $assert->mixed($loaded->getShortId(ord('q')))->identicalTo(0);
+        $assert->string($loaded->getHelp())->is($options->getHelp());
+        $assert->string(OptionSetCache::hash($loaded))->is(OptionSetCache::hash($options));
+        $assert->string(OptionSetCache::hash($options))->is(OptionSetCache::hashSpecs(self::specs()));
+        $assert->mixed($loaded->flatten())->identicalTo($loaded);
+        $assert->mixed($loaded->getConstraints()->getConstraints()[0]->getIds())->looselyEquals(ImmVector{0, 1});
+        $cmd = (new Parser($loaded))->parse(['test.hh', '-vv', '--size', '2K']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'v' => 2, 'size' => 2048});
+        $assert->whenCalled(() ==> {(new Parser($loaded))->parse(['test.hh', '-qv']);})
+            ->willThrowClassWithMessage(ConstraintException::class,
+                'Options -q and -v cannot be used together');
+    }
+
+    <<Test>>
+    public async function testInvalid(Assert $assert): Awaitable<void>
+    {
+        $snapshot = OptionSetCache::export(self::optionSet(), '1.0');
+        $assert->whenCalled(() ==> {OptionSetCache::import($snapshot, '2.0');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Option set snapshot has version 1.0, expected 2.0');
+        $specs = self::specs();
+        $specs['q|quiet'] = 'Be loud!';
+        $assert->whenCalled(() ==> {OptionSetCache::import($snapshot, '1.0', $specs);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                "Option set snapshot doesn't match the specs");
+        $assert->whenCalled(() ==> {OptionSetCache::import(str_replace('Be quiet', 'Be loud!', $snapshot), '1.0');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                "Option set snapshot doesn't match its hash");
+        $assert->whenCalled(() ==> {OptionSetCache::import(substr($snapshot, 0, -10), '1.0');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Invalid option set snapshot');
+        $parts = explode("\n", $snapshot, 4);
+        $parts[3] = serialize(new \ArrayObject([self::optionSet()]));
+        $assert->whenCalled(() ==> {OptionSetCache::import(implode("\n", $parts), '1.0');})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Invalid option set snapshot');
+    }
+
+    <<Test>>
+    public async function testLoadFile(Assert $assert): Awaitable<void>
+    {
+        $path = tempnam(sys_get_temp_dir(), 'cleo');
+        unlink($path);
+        $builds = Vector{};
+        $build = () ==> {
+            $builds[] = true;
+            return self::optionSet();
+        };
+        $first = OptionSetCache::loadFile($path, '1.0', self::specs(), $build);
+        $second = OptionSetCache::loadFile($path, '1.0', self::specs(), $build);
+        $assert->int($builds->count())->eq(1);
+        $assert->mixed($second->getLongId('verbose'))->identicalTo($first->getLongId('verbose'));
+        OptionSetCache::loadFile($path, '1.1', self::specs(), $build);
+        $assert->int($builds->count())->eq(2);
+        $specs = self::specs();
+        $specs['size:bytes'] = 'The maximum size';
+        OptionSetCache::loadFile($path, '1.1', $specs, $build);
+        $assert->int($builds->count())->eq(3);
+        unlink($path);
+    }
+
+    private static function specs(): Map<string,string>
+    {
+        return Map{
+            'q|quiet' => 'Be quiet',
+            'v|verbose+' => 'Enable verbose mode',
+            'd|directory:' => 'The directory',
+            'size:bytes' => 'The size',
+        };
+    }
+
+    private static function optionSet(): OptionSet
+    {
+        return (new OptionSet(
+            new Option("q|quiet", "Be quiet"),
+            new Option("v|verbose+", "Enable verbose mode")
+        ))->exclusive('quiet', 'verbose')->combine(new OptionSet(
+            new Option("d|directory:", "The directory"),
+            new Option("size:bytes", "The size")
+        ));
+    }
+}
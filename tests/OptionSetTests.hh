@@ -80,4 +80,95 @@ class OptionSetTests
             ->willThrowClassWithMessage(\InvalidArgumentException::class,
                 'Duplicate option: --verbose');
     }
+
+    <<Test>>
+    public async function testIds(Assert $assert): Awaitable<void>
+    {
+        $verbose = new Option("v|verbose+", "Enable verbose mode");
+        $set = new OptionSet(
+            new Option("d|directory:", "The directory"),
+            $verbose
+        );
+        $assert->mixed($set->getShortId(ord('v')))->identicalTo(1);
+        $assert->mixed($set->getLongId('verbose'))->identicalTo(1);
+        $assert->mixed($set->getLongId('v'))->identicalTo(1);
+        $assert->mixed($set->getLongId('directory'))->identicalTo(0);
+        $assert->mixed($set->getShortId(ord('x')))->isNull();
+        $assert->mixed($set->getShortId(200))->isNull();
+        $assert->mixed($set->getLongId('nope'))->isNull();
+        $assert->mixed($set->getOptionById(1))->identicalTo($verbose);
+        $assert->mixed($set->getOption('verbose'))->identicalTo($verbose);
+        $assert->int($set->getFlags(0))->eq(Option::REQUIRED);
+    }
+
+    <<Test>>
+    public async function testCombineLayers(Assert $assert): Awaitable<void>
+    {
+        $size = new Option("s|size:", "The size");
+        $set = new OptionSet(
+            new Option("d|directory:", "The directory"),
+            new Option("v|verbose+", "Enable verbose mode")
+        );
+        $middle = $set->combine(new OptionSet(new Option("q|quiet", "Be quiet")));
+        $top = $middle->combine(new OptionSet($size));
+        $assert->int($top->count())->eq(4);
+        $assert->mixed($top->getLongId('directory'))->identicalTo(0);
+        $assert->mixed($top->getLongId('quiet'))->identicalTo(2);
+        $assert->mixed($top->getShortId(ord('s')))->identicalTo(3);
+        $assert->mixed($top->getOption('size'))->identicalTo($size);
+        $assert->int($top->getFlags(3))->eq(Option::REQUIRED);
+        $assert->mixed($middle->getLongId('size'))->isNull();
+        $assert->int($middle->count())->eq(3);
+        $assert->whenCalled(() ==> {$top->combine(new OptionSet(new Option("x|directory", "Again")));})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Duplicate option: --directory');
+    }
+
+    <<Test>>
+    public async function testCombineManyLayers(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(new Option("option-0", "Option 0"));
+        for ($i = 1; $i < 300; $i++) {
+            $set = $set->combine(new OptionSet(new Option("option-$i", "Option $i")));
+        }
+        $assert->int($set->count())->eq(300);
+        $assert->mixed($set->getLongId('option-0'))->identicalTo(0);
+        $assert->mixed($set->getLongId('option-150'))->identicalTo(150);
+        $assert->mixed($set->getLongId('option-299'))->identicalTo(299);
+        $assert->whenCalled(() ==> {$set->combine(new OptionSet(new Option("option-150", "Again")));})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Duplicate option: --option-150');
+        $top = $set->combine(new OptionSet(new Option("option-300", "Option 300")));
+        $assert->mixed($top->getLongId('option-300'))->identicalTo(300);
+        $assert->mixed($top->getLongId('option-1'))->identicalTo(1);
+    }
+
+    <<Test>>
+    public async function testConstraints(Assert $assert): Awaitable<void>
+    {
+        $set = (new OptionSet(
+            new Option("q|quiet", "Be quiet"),
+            new Option("v|verbose+", "Enable verbose mode")
+        ))->exclusive('quiet', 'verbose');
+        $top = $set->combine((new OptionSet(
+            new Option("user:", "The user"),
+            new Option("password:", "The password")
+        ))->requires('user', 'password'));
+        $constraints = $top->getConstraints()->getConstraints();
+        $assert->int($constraints->count())->eq(2);
+        $assert->mixed($constraints[0]->getIds())->looselyEquals(ImmVector{0, 1});
+        $assert->int($constraints[1]->getSubject())->eq(2);
+        $assert->mixed($constraints[1]->getIds())->looselyEquals(ImmVector{3});
+        $assert->int($set->getConstraints()->getConstraints()->count())->eq(1);
+        $set->atLeastOne('quiet', 'verbose');
+        $assert->int($set->getConstraints()->getConstraints()->count())->eq(2);
+        $assert->int($top->getConstraints()->getConstraints()->count())->eq(2);
+        $assert->int($top->getConstraints()->check([])->count())->eq(0);
+        $assert->whenCalled(() ==> {$set->atLeastOne('quiet', 'loud');})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Unknown option: loud');
+        $assert->whenCalled(() ==> {$set->exclusive('quiet');})
+            ->willThrowClassWithMessage(\InvalidArgumentException::class,
+                'Exclusive options need at least two labels');
+    }
 }
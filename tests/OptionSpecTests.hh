@@ -0,0 +1,39 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class OptionSpecTests
+{
+    <<Test>>
+    public async function testShared(Assert $assert): Awaitable<void>
+    {
+        $a = new Option('e|exclude:s@', 'Excludes files');
+        $b = new Option('e|exclude:s@', 'Excludes folders');
+        $assert->mixed($a->getSpec())->identicalTo($b->getSpec());
+        $assert->string($a->getDescription())->is('Excludes files');
+        $assert->string($b->getDescription())->is('Excludes folders');
+        $assert->string($a->getSpec()->getSpec())->is('e|exclude:s@');
+    }
+
+    <<Test>>
+    public async function testClearCache(Assert $assert): Awaitable<void>
+    {
+        $a = OptionSpec::compile('v|verbose+');
+        OptionSpec::clearCache();
+        $b = OptionSpec::compile('v|verbose+');
+        $assert->mixed($a)->not()->identicalTo($b);
+        $assert->int($b->getFlags())->eq($a->getFlags());
+    }
+
+    <<Test>>
+    public async function testCacheLimit(Assert $assert): Awaitable<void>
+    {
+        OptionSpec::setCacheLimit(1);
+        $a = OptionSpec::compile('a');
+        OptionSpec::compile('b');
+        $assert->mixed(OptionSpec::compile('a'))->not()->identicalTo($a);
+        OptionSpec::setCacheLimit(1024);
+    }
+}
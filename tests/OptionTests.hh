@@ -114,4 +114,17 @@ class OptionTests
                     'Option labels must only contain letters, numbers, and the dash');
         }
     }
+
+    <<Test>>
+    public async function testFlags(Assert $assert): Awaitable<void>
+    {
+        $assert->int((new Option('v|verbose', ''))->getFlags())->eq(0);
+        $assert->int((new Option('v|verbose+', ''))->getFlags())
+            ->eq(Option::INCREMENTAL | Option::TYPE_INTEGER);
+        $assert->int((new Option('d|dir::', ''))->getFlags())->eq(Option::OPTIONAL);
+        $assert->int((new Option('c|count:f@', ''))->getFlags())
+            ->eq(Option::REQUIRED | Option::MULTIPLE | Option::TYPE_FLOAT);
+        $assert->int((new Option('when:d', ''))->getFlags())
+            ->eq(Option::REQUIRED | Option::TYPE_DATE);
+    }
 }
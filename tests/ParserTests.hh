@@ -99,4 +99,278 @@ class ParserTests
         $assert->mixed($cmd->getOptions())->looselyEquals(Map{'v' => true});
         $assert->container($cmd->getArguments())->containsAll(Vector{'src', 'tests'});
     }
+
+    <<Test>>
+    public async function testParseSeven(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("d|directory:", "Directory")
+        ));
+        $cmd = $parser->parse(['test.hh', '-' . str_repeat('v', 100000) . 'd', 'src']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'v' => 100000, 'd' => 'src'});
+        $assert->container($cmd->getArguments())->isEmpty();
+    }
+
+    <<Test>>
+    public async function testParseEvents(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("n|nice:i", "Nice value")
+        ));
+        $events = Vector{};
+        foreach ($parser->parseEvents(['test.hh', 'a', '-vn', '5', '--verbose', '--', '-b']) as $event) {
+            $events[] = Vector{$event->getType(), $event->getLabel(), $event->getValue()};
+        }
+        $assert->mixed($events)->looselyEquals(Vector{
+            Vector{EventType::PROGRAM, '', 'test.hh'},
+            Vector{EventType::ARGUMENT, '', 'a'},
+            Vector{EventType::OPTION, 'v', 1},
+            Vector{EventType::OPTION, 'n', 5},
+            Vector{EventType::OPTION, 'verbose', 1},
+            Vector{EventType::END_OF_OPTIONS, '', null},
+            Vector{EventType::ARGUMENT, '', '-b'},
+        });
+    }
+
+    <<Test>>
+    public async function testParseLazy(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(new OptionSet(
+            new Option("d|date:d@", "Dates"),
+            new Option("n|nice:i", "Nice value")
+        ), Parser::LAZY);
+        $cmd = $parser->parse(['test.hh', '-d', '2016-01-01', '-d2016-02-01', '--nice=5']);
+        $assert->mixed($cmd->getRawOptions())->looselyEquals(ImmMap{'d' => Vector{'2016-01-01', '2016-02-01'}, 'nice' => '5'});
+        $assert->mixed($cmd->getOption('nice'))->identicalTo(5);
+        $dates = $cmd->getOption('d');
+        $assert->mixed($dates)->looselyEquals(Vector{new \DateTimeImmutable('2016-01-01'), new \DateTimeImmutable('2016-02-01')});
+        $assert->mixed($cmd->getOption('d'))->identicalTo($dates);
+        $assert->mixed($cmd->getOptions())->looselyEquals(ImmMap{'d' => $dates, 'nice' => 5});
+        $assert->bool($cmd->hasOption('x'))->is(false);
+    }
+
+    <<Test>>
+    public async function testParseAliases(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("e|exclude:@", "Excludes"),
+            new Option("n|nice:i", "Nice value"),
+            new Option("q|quiet", "Quiet")
+        );
+        $parser = new Parser($set);
+        $cmd = $parser->parse(['test.hh', '--verbose', '-e', 'a', '-v', '--exclude=b', '--nice', '7']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'verbose' => 1, 'e' => Vector{'a'}, 'v' => 1, 'exclude' => Vector{'b'}, 'nice' => 7});
+        $assert->mixed($cmd->getMergedOptions())->looselyEquals(Map{'verbose' => 2, 'e' => Vector{'a', 'b'}, 'nice' => 7});
+        $lazy = (new Parser($set, Parser::LAZY))->parse(['test.hh', '-n1', '--nice=2', '-n', '3', '-e', 'a', '--exclude', 'b', '-e', 'c']);
+        $assert->mixed($lazy->getOptions())->looselyEquals(Map{'n' => 3, 'nice' => 2, 'e' => Vector{'a', 'c'}, 'exclude' => Vector{'b'}});
+        $assert->mixed($lazy->getRawOptions())->looselyEquals(Map{'n' => '3', 'nice' => '2', 'e' => Vector{'a', 'c'}, 'exclude' => Vector{'b'}});
+        $assert->int($cmd->getCount('v'))->eq(2);
+        $assert->int($cmd->getCount('verbose'))->eq(2);
+        $assert->int($cmd->getCount('exclude'))->eq(2);
+        $assert->int($cmd->getCount('quiet'))->eq(0);
+        $assert->int($cmd->getCount('nice'))->eq(1);
+        $plain = new Command('test.hh', ImmMap{'nice' => 7, 'v' => 2}, ImmVector{});
+        $assert->int($plain->getCount('nice'))->eq(1);
+        $assert->int($plain->getCount('v'))->eq(1);
+        $assert->int($cmd->getInt('n'))->eq(7);
+        $assert->int($cmd->getInt('x', 3))->eq(3);
+        $assert->string($cmd->getString('q', 'no'))->is('no');
+        $assert->mixed($cmd->getVector('exclude'))->looselyEquals(ImmVector{'a', 'b'});
+        $assert->mixed($cmd->getVector('nice'))->looselyEquals(ImmVector{7});
+        $assert->bool($cmd->hasOption('e'))->is(true);
+        $assert->bool($cmd->hasOption('quiet'))->is(false);
+        $values = $cmd->getValues();
+        $assert->mixed($values === null ? null : $values->toNamedMap())
+            ->looselyEquals(ImmMap{'v' => 2, 'e' => Vector{'a', 'b'}, 'n' => 7});
+    }
+
+    <<Test>>
+    public async function testParseAbbreviated(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(
+            new Option("v|verbose|verb-level+", "Verbosity"),
+            new Option("version", "Show the version"),
+            new Option("directory:", "The directory")
+        );
+        $parser = new Parser($set, Parser::ABBREVIATE);
+        $cmd = $parser->parse(['test.hh', '--verbo', '--dir', 'src', '--vers']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'verbose' => 1, 'directory' => 'src', 'version' => true});
+        $cmd = $parser->parse(['test.hh', '--verb', '--di=src']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'verb-level' => 1, 'directory' => 'src'});
+        $assert->whenCalled(() ==> {$parser->parse(['test.hh', '--ver']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Ambiguous option: --ver could be --verb-level, --verbose, --version');
+        $assert->whenCalled(() ==> {(new Parser($set))->parse(['test.hh', '--verbo']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: --verbo');
+        $assert->whenCalled(() ==> {$parser->parse(['test.hh', '--=src']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: --');
+        $only = new Parser(new OptionSet(new Option("d|directory:", "The directory")), Parser::ABBREVIATE);
+        $assert->whenCalled(() ==> {$only->parse(['test.hh', '--=src']);})
+            ->willThrowClassWithMessage(\UnexpectedValueException::class,
+                'Unknown option: --');
+        $assert->mixed($set->getLongCandidates(''))->looselyEquals(ImmVector{});
+        $assert->string($set->expandLongLabel(''))->is('');
+    }
+
+    <<Test>>
+    public async function testParseRepeatedly(Assert $assert): Awaitable<void>
+    {
+        $set = new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("e|exclude:@", "Excludes"),
+            new Option("q|quiet", "Quiet")
+        );
+        $parser = new Parser($set->prepare());
+        $commands = Vector{};
+        foreach ([['test.hh', '-vv', '-e', 'a', 'src'], ['test.hh', '-q'], ['test.hh', '--exclude=b', '-v']] as $arguments) {
+            $commands[] = $parser->parse($arguments);
+        }
+        $assert->mixed($commands[0]->getOptions())->looselyEquals(Map{'v' => 2, 'e' => Vector{'a'}});
+        $assert->mixed($commands[0]->getArguments())->looselyEquals(ImmVector{'src'});
+        $assert->mixed($commands[1]->getOptions())->looselyEquals(Map{'q' => true});
+        $assert->mixed($commands[2]->getOptions())->looselyEquals(Map{'exclude' => Vector{'b'}, 'v' => 1});
+    }
+
+    <<Test>>
+    public async function testTryParse(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("verify", "Verify"),
+            new Option("d|directory:", "The directory"),
+            new Option("q|quiet", "Quiet")
+        ), Parser::ABBREVIATE);
+        $result = $parser->tryParse(['test.hh', '-vxq', '--ver', '--quiet=yes', '--nope', 'src', '-d', '-v', '-d']);
+        $assert->bool($result->isValid())->is(false);
+        $diagnostics = $result->getDiagnostics()->map($d ==> Vector{$d->getKind(), $d->getIndex(), $d->getOffset(), $d->getLabel()});
+        $assert->mixed($diagnostics)->looselyEquals(ImmVector{
+            Vector{DiagnosticKind::UNKNOWN_OPTION, 1, 2, 'x'},
+            Vector{DiagnosticKind::AMBIGUOUS_OPTION, 2, 0, 'ver'},
+            Vector{DiagnosticKind::UNEXPECTED_VALUE, 3, 7, 'quiet'},
+            Vector{DiagnosticKind::UNKNOWN_OPTION, 4, 0, 'nope'},
+            Vector{DiagnosticKind::MISSING_VALUE, 6, 0, 'd'},
+            Vector{DiagnosticKind::MISSING_VALUE, 8, 0, 'd'},
+        });
+        $assert->string($result->getDiagnostics()[1]->getMessage())
+            ->is('Ambiguous option: --ver could be --verbose, --verify');
+        $cmd = $result->getCommand();
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'v' => 2, 'q' => true});
+        $assert->mixed($cmd->getArguments())->looselyEquals(ImmVector{'src'});
+        $assert->bool($parser->tryParse(['test.hh', '-v', 'a'])->isValid())->is(true);
+        $assert->mixed($parser->tryParse([])->getDiagnostics()[0]->getKind())
+            ->identicalTo(DiagnosticKind::NO_ARGUMENTS);
+        foreach ([0, Parser::LAZY] as $mode) {
+            $parser = new Parser(new OptionSet(
+                new Option("size:bytes", "The size"),
+                new Option("t|timeout:duration", "The timeout")
+            ), $mode);
+            $result = $parser->tryParse(['test.hh', '--size=lots', '-t', 'forever', '-t5s']);
+            $diagnostics = $result->getDiagnostics()->map($d ==> Vector{$d->getKind(), $d->getIndex(), $d->getOffset(), $d->getLabel(), $d->getMessage()});
+            $assert->mixed($diagnostics)->looselyEquals(ImmVector{
+                Vector{DiagnosticKind::INVALID_VALUE, 1, 7, 'size', 'Invalid byte size: lots'},
+                Vector{DiagnosticKind::INVALID_VALUE, 3, 0, 't', 'Invalid duration: forever'},
+            });
+            $assert->mixed($result->getCommand()->getOptions())->looselyEquals(Map{'t' => 5.0});
+        }
+    }
+
+    <<Test>>
+    public async function testObserve(Assert $assert): Awaitable<void>
+    {
+        $metrics = new ParseMetrics();
+        OptionSpec::clearCache();
+        OptionSpec::setObserver($metrics);
+        $set = new OptionSet(
+            new Option("v|verbose+", "Verbosity"),
+            new Option("n|nice:i", "Nice value")
+        );
+        OptionSpec::setObserver(null);
+        $parser = (new Parser($set))->observe($metrics);
+        $cmd = $parser->parse(['test.hh', '-vv', '--nice', '7', 'src']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'v' => 2, 'nice' => 7});
+        $snapshot = $metrics->snapshot();
+        $assert->mixed($snapshot['phases']['compile']['count'])->identicalTo(2);
+        $assert->mixed($snapshot['phases']['parse']['count'])->identicalTo(1);
+        $assert->mixed($snapshot['phases']['tokenize']['count'])->identicalTo(1);
+        $assert->mixed($snapshot['phases']['lookup']['count'])->identicalTo(3);
+        $assert->mixed($snapshot['phases']['convert']['count'])->identicalTo(3);
+        $assert->mixed($snapshot['options']['v']['count'])->identicalTo(2);
+        $assert->mixed($snapshot['options']['n']['count'])->identicalTo(1);
+        $metrics->reset();
+        $assert->bool($metrics->snapshot()['phases']->isEmpty())->is(true);
+        // an alias is timed with its value, and an invalid value is still timed as a conversion
+        $result = $parser->tryParse(['test.hh', '-n', '1', '--nice=x', '--nice=2']);
+        $assert->mixed($result->getCommand()->getOptions())->looselyEquals(Map{'n' => 1, 'nice' => 2});
+        $snapshot = $metrics->snapshot();
+        $assert->mixed($snapshot['phases']['lookup']['count'])->identicalTo(3);
+        $assert->mixed($snapshot['phases']['convert']['count'])->identicalTo(3);
+        $assert->mixed($snapshot['options']['n']['count'])->identicalTo(2);
+    }
+
+    <<Test>>
+    public async function testParseValueList(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(new OptionSet(
+            (new Option("e|exclude:@", "Excludes"))->setUnique(),
+            (new Option("f|file:@", "Files"))->setLimit(2),
+            (new Option("n|number:i@", "Numbers"))->setInterned()
+        ));
+        $cmd = $parser->parse(['test.hh', '-e', 'a', '-eb', '--exclude=a', '-f', 'x', '-f', 'y', '-f', 'z', '-n1', '-n', '1', '-n2']);
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{
+            'e' => Vector{'a', 'b'},
+            'exclude' => Vector{'a'},
+            'f' => Vector{'x', 'y'},
+            'n' => Vector{1, 1, 2},
+        });
+        $assert->mixed($cmd->getMergedOptions())->looselyEquals(Map{
+            'e' => Vector{'a', 'b'},
+            'f' => Vector{'x', 'y'},
+            'n' => Vector{1, 1, 2},
+        });
+        $assert->int($cmd->getCount('exclude'))->eq(2);
+        $assert->mixed($cmd->getVector('number'))->looselyEquals(ImmVector{1, 1, 2});
+        $parser = new Parser(new OptionSet(
+            (new Option("r|ratio:f@", "Ratios"))->setUnique()
+        ));
+        $cmd = $parser->parse(['test.hh', '-r', '0.30000000000000004', '-r', '0.3', '-r', '3e-1']);
+        $assert->int($cmd->getCount('r'))->eq(2);
+        $assert->mixed($cmd->getVector('r'))->looselyEquals(ImmVector{0.1 + 0.2, 0.3});
+        foreach ([0, Parser::LAZY] as $mode) {
+            $parser = new Parser(new OptionSet(
+                (new Option("n|number:i@", "Numbers"))->setUnique()
+            ), $mode);
+            $cmd = $parser->parse(['test.hh', '-n1', '-n01', '-n', '2']);
+            $assert->mixed($cmd->getVector('n'))->looselyEquals(ImmVector{1, 2});
+        }
+    }
+
+    <<Test>>
+    public async function testParseConstraints(Assert $assert): Awaitable<void>
+    {
+        $options = (new OptionSet(
+            new Option("q|quiet", "Be quiet"),
+            new Option("v|verbose+", "Enable verbose mode"),
+            new Option("user:", "The user"),
+            new Option("password:", "The password"),
+            new Option("f|file:@", "Files"),
+            new Option("stdin", "Read standard input")
+        ))->exclusive('quiet', 'verbose')->requires('user', 'password')->atLeastOne('file', 'stdin');
+        $parser = new Parser($options);
+        $cmd = $parser->parse(['test.hh', '-v', '--user', 'me', '--password', 'secret', '--stdin']);
+        $assert->int($cmd->getCount('verbose'))->eq(1);
+        $assert->whenCalled(() ==> {$parser->parse(['test.hh', '-qv', '--user', 'me']);})
+            ->willThrowClassWithMessage(ConstraintException::class,
+                "Options -q and -v cannot be used together" . PHP_EOL .
+                "Option --user requires --password" . PHP_EOL .
+                "One of -f, --stdin is required");
+        $result = $parser->tryParse(['test.hh', '-q', '--verbose', '-f', 'a.txt', '--nope']);
+        $assert->mixed($result->getDiagnostics()->map($d ==> $d->getKind()))
+            ->looselyEquals(ImmVector{DiagnosticKind::UNKNOWN_OPTION, DiagnosticKind::CONSTRAINT});
+        $assert->string($result->getDiagnostics()[1]->getLabel())->is('q');
+    }
 }
@@ -0,0 +1,41 @@
+<?hh
+
+namespace Cleopatra;
+
+use HackPack\HackUnit\Contract\Assert;
+
+class ShellWordsTests
+{
+    <<Test>>
+    public async function testSplit(Assert $assert): Awaitable<void>
+    {
+        $words = ShellWords::split("test.hh  -e 'a b' --log=\"x \\\"y\\\" \\z\"\tc\\ d '' \\\n e\\\nf \$HOME");
+        $assert->mixed(new Vector($words))->looselyEquals(Vector{
+            'test.hh', '-e', 'a b', '--log=x "y" \\z', 'c d', '', 'ef', '$HOME'
+        });
+        $assert->mixed(new Vector(ShellWords::split(" \t\n")))->looselyEquals(Vector{});
+    }
+
+    <<Test>>
+    public async function testParse(Assert $assert): Awaitable<void>
+    {
+        $parser = new Parser(new OptionSet(new Option("e|exclude:@", "Excludes")));
+        $cmd = $parser->parse(ShellWords::split("test.hh -e 'a b' src"));
+        $assert->mixed($cmd->getOptions())->looselyEquals(Map{'e' => Vector{'a b'}});
+        $assert->mixed($cmd->getArguments())->looselyEquals(ImmVector{'src'});
+    }
+
+    <<Test>>
+    public async function testErrors(Assert $assert): Awaitable<void>
+    {
+        $assert->whenCalled(() ==> {new Vector(ShellWords::split("test.hh 'abc"));})
+            ->willThrowClassWithMessage(SyntaxException::class,
+                'Unterminated single quote at offset 8');
+        $assert->whenCalled(() ==> {new Vector(ShellWords::split('a "b\\"'));})
+            ->willThrowClassWithMessage(SyntaxException::class,
+                'Unterminated double quote at offset 2');
+        $assert->whenCalled(() ==> {new Vector(ShellWords::split('a\\'));})
+            ->willThrowClassWithMessage(SyntaxException::class,
+                'Unterminated escape at offset 1');
+    }
+}